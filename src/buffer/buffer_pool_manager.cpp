@@ -12,46 +12,202 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <list>
-#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // We allocate a consecutive memory space for the buffer pool.
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     size_t num_shards, ReplacerPolicy replacer_policy)
+    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager), shards_(num_shards) {
+  BUSTUB_ASSERT(num_shards > 0 && num_shards <= pool_size, "Every shard needs at least one frame.");
+  // We allocate a consecutive memory space for the buffer pool, the frame data is kept apart from the metadata.
   pages_ = new Page[pool_size_];
-  replacer_ = new ClockReplacer(pool_size);
-
-  // Initially, every page is in the free list.
+  arena_size_ = (pool_size_ * PAGE_SIZE + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  arena_ = allocate_arena(arena_size_);
   for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+    pages_[i].data_ = arena_ + i * PAGE_SIZE;
+  }
+
+  // Split the frames as evenly as possible, the first pool_size % num_shards shards get one extra frame.
+  size_t next_frame = 0;
+  for (size_t i = 0; i < num_shards; ++i) {
+    auto &shard = shards_[i];
+    shard.num_frames_ = pool_size_ / num_shards + (i < pool_size_ % num_shards ? 1 : 0);
+    shard.pages_ = pages_ + next_frame;
+    shard.page_table_ = new PageTable(shard.num_frames_);
+    shard.write_back_buffer_ = static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+    if (replacer_policy == ReplacerPolicy::LRU_K) {
+      shard.replacer_ = new LRUKReplacer(shard.num_frames_);
+    } else {
+      shard.replacer_ = new ClockReplacer(shard.num_frames_);
+    }
+    // Initially, every page is in the free list.
+    for (size_t j = 0; j < shard.num_frames_; ++j) {
+      shard.free_list_.emplace_back(static_cast<frame_id_t>(j));
+    }
+    next_frame += shard.num_frames_;
+  }
+
+  mmap_disk_manager_ = dynamic_cast<MmapDiskManager *>(disk_manager);
+  if (mmap_disk_manager_ != nullptr) {
+    views_ = new Page[mmap_disk_manager_->GetNumPages()];
+    for (size_t i = 0; i < mmap_disk_manager_->GetNumPages(); ++i) {
+      // Unallocated pages have no data and cannot be fetched.
+      views_[i].data_ = const_cast<char *>(mmap_disk_manager_->GetPageData(static_cast<page_id_t>(i)));
+      views_[i].page_id_ = static_cast<page_id_t>(i);
+    }
   }
 }
 
 BufferPoolManager::~BufferPoolManager() {
+  StopPageCleaner();
+  if (prefetch_thread_ != nullptr) {
+    {
+      std::lock_guard<std::mutex> guard(prefetch_latch_);
+      run_prefetcher_ = false;
+    }
+    prefetch_cv_.notify_one();
+    prefetch_thread_->join();
+    delete prefetch_thread_;
+  }
   delete[] pages_;
-  delete replacer_;
+  delete[] views_;
+  munmap(arena_, arena_size_);
+  for (auto &shard : shards_) {
+    wait_write_back(&shard);
+    free(shard.write_back_buffer_);
+    delete shard.page_table_;
+    delete shard.replacer_;
+  }
 }
 
-auto BufferPoolManager::get_free_page(bool has_latch) -> frame_id_t {
-  std::unique_lock<std::mutex> ulck;
-  if (!has_latch) {
-    ulck = std::unique_lock<std::mutex>(latch_);
+auto BufferPoolManager::allocate_arena(size_t size) -> char * {
+  void *arena = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (arena != MAP_FAILED) {
+    return static_cast<char *>(arena);
+  }
+  // No explicit huge pages reserved: map one huge page more than needed, trim the mapping to a huge page boundary and
+  // ask for transparent huge pages instead.
+  arena = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (arena == MAP_FAILED) {
+    throw Exception("cannot allocate the buffer pool");
   }
+  auto start = reinterpret_cast<uintptr_t>(arena);
+  auto aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  if (aligned != start) {
+    munmap(arena, aligned - start);
+  }
+  if (aligned + size != start + size + HUGE_PAGE_SIZE) {
+    munmap(reinterpret_cast<void *>(aligned + size), start + HUGE_PAGE_SIZE - aligned);
+  }
+  madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+  return reinterpret_cast<char *>(aligned);
+}
+
+auto BufferPoolManager::get_free_page(Shard *shard) -> frame_id_t {
   frame_id_t frame_id;
-  if (free_list_.empty()) {
-    if (!replacer_->Victim(&frame_id)) {
-      return -1;
-    }
-    DeletePageImpl(pages_[frame_id].page_id_, true);
+  if (!shard->free_list_.empty()) {
+    frame_id = shard->free_list_.back();
+    shard->free_list_.pop_back();
+    shard->replacer_->Pin(frame_id);
+    return frame_id;
+  }
+  if (!shard->replacer_->Victim(&frame_id)) {
+    return -1;
   }
-  frame_id = free_list_.back();
-  free_list_.pop_back();
-  replacer_->Pin(frame_id);
+  // The frame is about to be pinned by the caller, which counts as an access of the page it will hold.
+  shard->replacer_->Pin(frame_id);
+  // Evict the victim: write it back if it is dirty and drop it from the page table. Unlike DeletePageImpl the page
+  // stays allocated on disk.
+  auto &victim = shard->pages_[frame_id];
+  if (victim.IsDirty()) {
+    // Write from a copy so that the frame can be reused right away. The buffer holds one victim at a time.
+    wait_write_back(shard);
+    flush_log_for(&victim);
+    memcpy(shard->write_back_buffer_, victim.GetData(), PAGE_SIZE);
+    shard->write_back_page_id_ = victim.page_id_;
+    shard->write_back_clean_lsn_ = victim.clean_lsn_;
+    shard->write_back_ = disk_manager_->WritePageAsync(victim.page_id_, shard->write_back_buffer_);
+    num_foreground_writes_ += 1;
+    // The cleaner is falling behind, do not wait for its next round.
+    cleaner_cv_.notify_one();
+  }
+  shard->page_table_->Remove(victim.page_id_);
+  victim.page_id_ = INVALID_PAGE_ID;
+  victim.pin_count_ = 0;
+  victim.is_dirty_ = false;
   return frame_id;
 }
 
+void BufferPoolManager::flush_log_for(Page *page) {
+  // Pages without an LSN (e.g. hash table pages) hold arbitrary bytes there, Flush does not wait for LSNs that were
+  // not handed out.
+  if (enable_logging && log_manager_ != nullptr && page->GetLSN() > log_manager_->GetPersistentLSN()) {
+    log_manager_->Flush(page->GetLSN());
+  }
+}
+
+auto BufferPoolManager::next_lsn() -> lsn_t {
+  return log_manager_ != nullptr ? log_manager_->GetNextLSN() : INVALID_LSN;
+}
+
+void BufferPoolManager::wait_write_back(Shard *shard) {
+  if (shard->write_back_.valid()) {
+    shard->write_back_.get();
+    shard->write_back_page_id_ = INVALID_PAGE_ID;
+  }
+}
+
+auto BufferPoolManager::try_pin_resident(Shard *shard, page_id_t page_id) -> Page * {
+  frame_id_t frame_id;
+  if (!shard->page_table_->Find(page_id, &frame_id)) {
+    return nullptr;
+  }
+  auto &page = shard->pages_[frame_id];
+  // Only piggyback on frames that are already pinned: they cannot be evicted under us, and the 0 -> 1 transition,
+  // which has to update the replacer, stays under the shard latch.
+  int pin_count = page.pin_count_;
+  do {
+    if (pin_count <= 0) {
+      return nullptr;
+    }
+  } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  // The mapping may have been stale and the frame may be caching (or loading) another page by now.
+  if (page.page_id_ != page_id) {
+    if (!try_unpin(&page)) {
+      std::lock_guard<std::mutex> guard(shard->latch_);
+      unpin_frame(shard, frame_id);
+    }
+    return nullptr;
+  }
+  return &page;
+}
+
+auto BufferPoolManager::try_unpin(Page *page) -> bool {
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count <= 1) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  return true;
+}
+
+void BufferPoolManager::unpin_frame(Shard *shard, frame_id_t frame_id) {
+  if (shard->pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+    shard->replacer_->Unpin(frame_id);
+  }
+}
+
 auto BufferPoolManager::FetchPageImpl(page_id_t page_id, bool has_latch) -> Page * {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
@@ -60,87 +216,166 @@ auto BufferPoolManager::FetchPageImpl(page_id_t page_id, bool has_latch) -> Page
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  if (mmap_disk_manager_ != nullptr) {
+    return fetch_view(page_id);
+  }
+  auto &shard = GetShard(page_id);
   std::unique_lock<std::mutex> ulck;
   if (!has_latch) {
-    ulck = std::unique_lock<std::mutex>(latch_);
+    auto *page = try_pin_resident(&shard, page_id);
+    if (page != nullptr) {
+      return page;
+    }
+    ulck = std::unique_lock<std::mutex>(shard.latch_);
   }
-  if (page_table_.find(page_id) != page_table_.end()) {
-    auto frame_id = page_table_[page_id];
-    if (pages_[frame_id].pin_count_ == 0) {
-      replacer_->Pin(frame_id);
+  frame_id_t frame_id;
+  if (shard.page_table_->Find(page_id, &frame_id)) {
+    if (shard.pages_[frame_id].pin_count_ == 0) {
+      shard.replacer_->Pin(frame_id);
     }
-    pages_[frame_id].pin_count_ += 1;
-    return &pages_[frame_id];
+    shard.pages_[frame_id].pin_count_ += 1;
+    return &shard.pages_[frame_id];
   }
-  auto frame_id = get_free_page(true);
+  frame_id = get_free_page(&shard);
   if (frame_id == -1) {
     return nullptr;
   }
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].pin_count_ = 1;
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].ResetMemory();
-  disk_manager_->ReadPage(page_id, pages_[frame_id].data_);
-  page_table_[page_id] = frame_id;
-  return &pages_[frame_id];
+  // The page id is only published once the content is loaded, so that a latch-free reader holding a stale mapping to
+  // this frame cannot mistake it for a ready copy of the page.
+  auto &page = shard.pages_[frame_id];
+  page.pin_count_ = 1;
+  page.is_dirty_ = false;
+  page.ResetMemory();
+  // The page may just have been evicted, do not read it before its write back is done.
+  if (shard.write_back_page_id_ == page_id) {
+    wait_write_back(&shard);
+  }
+  try {
+    disk_manager_->ReadPage(page_id, page.data_);
+  } catch (Exception &e) {
+    // Do not cache a corrupted page, give the frame back.
+    page.pin_count_ = 0;
+    shard.free_list_.push_back(frame_id);
+    throw;
+  }
+  shard.num_misses_ += 1;
+  page.clean_lsn_ = next_lsn();
+  page.page_id_ = page_id;
+  shard.page_table_->Insert(page_id, frame_id);
+  return &page;
+}
+
+auto BufferPoolManager::fetch_view(page_id_t page_id) -> Page * {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= mmap_disk_manager_->GetNumPages() ||
+      views_[page_id].data_ == nullptr) {
+    return nullptr;
+  }
+  mmap_disk_manager_->VerifyPage(page_id);
+  views_[page_id].pin_count_ += 1;
+  return &views_[page_id];
 }
 
 auto BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty, bool has_latch) -> bool {
+  if (mmap_disk_manager_ != nullptr) {
+    BUSTUB_ASSERT(!is_dirty, "Pages of a mapped database file are read-only.");
+    if (page_id < 0 || static_cast<size_t>(page_id) >= mmap_disk_manager_->GetNumPages()) {
+      return false;
+    }
+    auto &page = views_[page_id];
+    int pin_count = page.pin_count_;
+    do {
+      if (pin_count <= 0) {
+        return false;
+      }
+    } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+    return true;
+  }
+  auto &shard = GetShard(page_id);
+  frame_id_t frame_id;
   std::unique_lock<std::mutex> ulck;
   if (!has_latch) {
-    ulck = std::unique_lock<std::mutex>(latch_);
+    // The caller holds a pin, so the page cannot move while we look at it.
+    if (shard.page_table_->Find(page_id, &frame_id) && shard.pages_[frame_id].page_id_ == page_id) {
+      auto &page = shard.pages_[frame_id];
+      if (is_dirty) {
+        page.is_dirty_ = true;
+      }
+      if (try_unpin(&page)) {
+        return true;
+      }
+    }
+    ulck = std::unique_lock<std::mutex>(shard.latch_);
   }
-  assert(page_table_.find(page_id) != page_table_.end());
-  auto frame_id = page_table_[page_id];
-  pages_[frame_id].is_dirty_ = is_dirty || pages_[frame_id].is_dirty_;
-  if (pages_[frame_id].GetPinCount() <= 0) {
-    return false;
+  [[maybe_unused]] bool found = shard.page_table_->Find(page_id, &frame_id);
+  assert(found);
+  auto &page = shard.pages_[frame_id];
+  if (is_dirty) {
+    page.is_dirty_ = true;
   }
-  pages_[frame_id].pin_count_ -= 1;
-  if (pages_[frame_id].GetPinCount() == 0) {
-    replacer_->Unpin(frame_id);
+  if (page.GetPinCount() <= 0) {
+    return false;
   }
+  unpin_frame(&shard, frame_id);
   return true;
 }
 
 auto BufferPoolManager::FlushPageImpl(page_id_t page_id, bool has_latch) -> bool {
   // Make sure you call DiskManager::WritePage!
+  assert(page_id != INVALID_PAGE_ID);
+  if (mmap_disk_manager_ != nullptr) {
+    // Views are never dirty.
+    return static_cast<size_t>(page_id) < mmap_disk_manager_->GetNumPages() && views_[page_id].data_ != nullptr;
+  }
+  auto &shard = GetShard(page_id);
   std::unique_lock<std::mutex> ulck;
   if (!has_latch) {
-    ulck = std::unique_lock<std::mutex>(latch_);
+    ulck = std::unique_lock<std::mutex>(shard.latch_);
   }
-  assert(page_id != INVALID_PAGE_ID);
-  if (page_table_.find(page_id) == page_table_.end()) {
+  frame_id_t frame_id;
+  if (!shard.page_table_->Find(page_id, &frame_id)) {
     return false;
   }
-  auto frame_id = page_table_[page_id];
-  if (pages_[frame_id].IsDirty()) {
-    disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+  auto &page = shard.pages_[frame_id];
+  if (page.IsDirty()) {
+    lsn_t clean_lsn = next_lsn();
+    flush_log_for(&page);
+    disk_manager_->WritePage(page_id, page.GetData());
+    page.is_dirty_ = false;
+    // A pinned page may be changing during the write, its older recLSN stays valid.
+    if (page.GetPinCount() == 0) {
+      page.clean_lsn_ = clean_lsn;
+    }
   }
   return true;
 }
 
-auto BufferPoolManager::NewPageImpl(page_id_t *page_id, bool has_latch) -> Page * {
+auto BufferPoolManager::NewPageImpl(page_id_t *page_id) -> Page * {
   // 0.   Make sure you call DiskManager::AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::unique_lock<std::mutex> ulck;
-  if (!has_latch) {
-    ulck = std::unique_lock<std::mutex>(latch_);
+  if (mmap_disk_manager_ != nullptr) {
+    *page_id = INVALID_PAGE_ID;
+    return nullptr;
   }
-  frame_id_t frame_id = get_free_page(true);
+  // The shard is chosen by page id, so the id has to be allocated before we know where to look for a frame.
+  *page_id = disk_manager_->AllocatePage();
+  auto &shard = GetShard(*page_id);
+  std::lock_guard<std::mutex> guard(shard.latch_);
+  frame_id_t frame_id = get_free_page(&shard);
   if (frame_id == -1) {
+    disk_manager_->DeallocatePage(*page_id);
     return nullptr;
   }
-  *page_id = disk_manager_->AllocatePage();
-  pages_[frame_id].page_id_ = *page_id;
-  pages_[frame_id].pin_count_ = 1;
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].ResetMemory();
-  page_table_[*page_id] = frame_id;
-  return &pages_[frame_id];
+  auto &page = shard.pages_[frame_id];
+  page.pin_count_ = 1;
+  page.is_dirty_ = false;
+  page.ResetMemory();
+  page.clean_lsn_ = next_lsn();
+  page.page_id_ = *page_id;
+  shard.page_table_->Insert(*page_id, frame_id);
+  return &page;
 }
 
 auto BufferPoolManager::DeletePageImpl(page_id_t page_id, bool has_latch) -> bool {
@@ -149,35 +384,275 @@ auto BufferPoolManager::DeletePageImpl(page_id_t page_id, bool has_latch) -> boo
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  if (mmap_disk_manager_ != nullptr) {
+    return false;
+  }
+  auto &shard = GetShard(page_id);
   std::unique_lock<std::mutex> ulck;
   if (!has_latch) {
-    ulck = std::unique_lock<std::mutex>(latch_);
+    ulck = std::unique_lock<std::mutex>(shard.latch_);
   }
-  if (page_table_.find(page_id) == page_table_.end()) {
+  frame_id_t frame_id;
+  if (!shard.page_table_->Find(page_id, &frame_id)) {
+    // The page may just have been evicted, its write back must not land after the page id is reused.
+    if (shard.write_back_page_id_ == page_id) {
+      wait_write_back(&shard);
+    }
+    disk_manager_->DeallocatePage(page_id);
     return true;
   }
-  if (pages_[page_table_[page_id]].GetPinCount() != 0) {
+  auto &page = shard.pages_[frame_id];
+  if (page.GetPinCount() != 0) {
     return false;
   }
   disk_manager_->DeallocatePage(page_id);
-  FlushPageImpl(page_id, true);
-  auto frame_id = page_table_[page_id];
-  page_table_.erase(page_id);
-  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  pages_[frame_id].pin_count_ = 0;
-  pages_[frame_id].is_dirty_ = false;
-  free_list_.push_back(frame_id);
+  shard.page_table_->Remove(page_id);
+  // The frame was unpinned and therefore sits in the replacer, take it out before handing it to the free list.
+  shard.replacer_->Remove(frame_id);
+  page.page_id_ = INVALID_PAGE_ID;
+  page.pin_count_ = 0;
+  page.is_dirty_ = false;
+  shard.free_list_.push_back(frame_id);
   return true;
 }
 
-void BufferPoolManager::FlushAllPagesImpl(bool has_latch) {
-  std::unique_lock<std::mutex> ulck;
-  if (!has_latch) {
-    ulck = std::unique_lock<std::mutex>(latch_);
+void BufferPoolManager::FlushAllPagesImpl() {
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard.latch_);
+    wait_write_back(&shard);
+    for (size_t i = 0; i < shard.num_frames_; ++i) {
+      page_id_t page_id = shard.pages_[i].page_id_;
+      if (page_id != INVALID_PAGE_ID) {
+        FlushPageImpl(page_id, true);
+      }
+    }
+  }
+}
+
+void BufferPoolManager::RunPageCleaner(double dirty_ratio) {
+  std::lock_guard<std::mutex> guard(cleaner_latch_);
+  if (cleaner_thread_ != nullptr) {
+    return;
   }
-  for (auto &iter : page_table_) {
-    auto page_id = iter.first;
-    FlushPageImpl(page_id, true);
+  dirty_ratio_ = dirty_ratio;
+  run_cleaner_ = true;
+  cleaner_thread_ = new std::thread([this] {
+    std::unique_lock<std::mutex> lock(cleaner_latch_);
+    while (run_cleaner_) {
+      cleaner_cv_.wait_for(lock, page_cleaner_interval);
+      if (!run_cleaner_) {
+        break;
+      }
+      lock.unlock();
+      for (auto &shard : shards_) {
+        clean_shard(&shard);
+      }
+      lock.lock();
+    }
+  });
+}
+
+void BufferPoolManager::StopPageCleaner() {
+  std::thread *cleaner_thread;
+  {
+    std::lock_guard<std::mutex> guard(cleaner_latch_);
+    if (cleaner_thread_ == nullptr) {
+      return;
+    }
+    run_cleaner_ = false;
+    cleaner_thread = cleaner_thread_;
+    cleaner_thread_ = nullptr;
+  }
+  cleaner_cv_.notify_one();
+  cleaner_thread->join();
+  delete cleaner_thread;
+}
+
+void BufferPoolManager::CleanPagesBefore(lsn_t lsn) {
+  clean_before_lsn_ = lsn;
+  cleaner_cv_.notify_one();
+}
+
+auto BufferPoolManager::GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table;
+  if (mmap_disk_manager_ != nullptr) {
+    return dirty_page_table;
+  }
+  for (auto &shard : shards_) {
+    // A frame only gets its first pin under the latch, the unpinned frames cannot change while we hold it.
+    std::lock_guard<std::mutex> guard(shard.latch_);
+    for (size_t i = 0; i < shard.num_frames_; ++i) {
+      auto &page = shard.pages_[i];
+      if (page.page_id_ != INVALID_PAGE_ID && (page.IsDirty() || page.GetPinCount() > 0)) {
+        dirty_page_table.emplace_back(page.page_id_, page.clean_lsn_);
+      }
+    }
+    if (shard.write_back_page_id_ != INVALID_PAGE_ID) {
+      dirty_page_table.emplace_back(shard.write_back_page_id_, shard.write_back_clean_lsn_);
+    }
+  }
+  return dirty_page_table;
+}
+
+void BufferPoolManager::clean_shard(Shard *shard) {
+  lsn_t clean_before_lsn = clean_before_lsn_;
+  size_t num_dirty = 0;
+  bool has_old_pages = false;
+  for (size_t i = 0; i < shard->num_frames_; ++i) {
+    if (shard->pages_[i].IsDirty()) {
+      num_dirty += 1;
+      has_old_pages = has_old_pages || shard->pages_[i].clean_lsn_ < clean_before_lsn;
+    }
+  }
+  auto high_watermark = static_cast<size_t>(dirty_ratio_ * static_cast<double>(shard->num_frames_));
+  bool over_watermark = num_dirty > high_watermark;
+  if (!over_watermark && !has_old_pages) {
+    return;
+  }
+  for (size_t i = 0; i < shard->num_frames_; ++i) {
+    bool lower_ratio = over_watermark && num_dirty > high_watermark / 2;
+    if (!lower_ratio && !has_old_pages) {
+      break;
+    }
+    auto frame_id = static_cast<frame_id_t>(i);
+    auto &page = shard->pages_[frame_id];
+    page_id_t page_id;
+    {
+      // Pin the frame so that it cannot be evicted while we write it without holding the latch. The dirty flag is
+      // cleared before the write: a modification that races with the write marks the page dirty again on unpin.
+      std::lock_guard<std::mutex> guard(shard->latch_);
+      page_id = page.page_id_;
+      if (page_id == INVALID_PAGE_ID || !page.IsDirty() || page.GetPinCount() != 0 ||
+          (!lower_ratio && page.clean_lsn_ >= clean_before_lsn)) {
+        continue;
+      }
+      shard->replacer_->Pin(frame_id);
+      page.pin_count_ = 1;
+      page.is_dirty_ = false;
+    }
+    // Changes wait for the read latch, those made after the write get at least the LSN taken before it.
+    page.RLatch();
+    lsn_t clean_lsn = next_lsn();
+    flush_log_for(&page);
+    disk_manager_->WritePage(page_id, page.GetData());
+    page.clean_lsn_ = clean_lsn;
+    page.RUnlatch();
+    num_background_writes_ += 1;
+    num_dirty -= 1;
+    UnpinPageImpl(page_id, false);
+  }
+}
+
+void BufferPoolManager::PrefetchPages(page_id_t page_id, size_t count, next_page_id_fn next_page_id) {
+  // Views need no read ahead, the kernel reads the mapping ahead of sequential accesses.
+  if (page_id == INVALID_PAGE_ID || count == 0 || mmap_disk_manager_ != nullptr) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    if (prefetch_thread_ == nullptr) {
+      run_prefetcher_ = true;
+      prefetch_thread_ = new std::thread([this] {
+        std::unique_lock<std::mutex> lock(prefetch_latch_);
+        while (true) {
+          prefetch_cv_.wait(lock, [this] { return !run_prefetcher_ || !prefetch_requests_.empty(); });
+          if (!run_prefetcher_) {
+            break;
+          }
+          auto request = std::move(prefetch_requests_.front());
+          prefetch_requests_.pop_front();
+          lock.unlock();
+          prefetch(request);
+          lock.lock();
+        }
+      });
+    }
+    if (prefetch_requests_.size() == MAX_PREFETCH_REQUESTS) {
+      prefetch_requests_.pop_front();
+    }
+    prefetch_requests_.push_back({page_id, count, std::move(next_page_id)});
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::prefetch(const PrefetchRequest &request) {
+  if (request.next_page_id_ == nullptr) {
+    prefetch_range(request.page_id_, request.count_);
+    return;
+  }
+  page_id_t page_id = request.page_id_;
+  for (size_t i = 0; i < request.count_ && page_id != INVALID_PAGE_ID; ++i) {
+    frame_id_t frame_id;
+    bool resident = GetShard(page_id).page_table_->Find(page_id, &frame_id);
+    Page *page;
+    try {
+      page = FetchPageImpl(page_id);
+    } catch (Exception &e) {
+      // Prefetching is best effort, a corrupted page is reported to whoever fetches it.
+      return;
+    }
+    if (page == nullptr) {
+      return;
+    }
+    if (!resident) {
+      num_prefetched_pages_ += 1;
+    }
+    page->RLatch();
+    auto next_page_id = request.next_page_id_(page->GetData());
+    page->RUnlatch();
+    UnpinPageImpl(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+void BufferPoolManager::prefetch_range(page_id_t page_id, size_t count) {
+  std::vector<std::vector<page_id_t>> shard_page_ids(shards_.size());
+  for (size_t i = 0; i < count; ++i) {
+    auto next_page_id = static_cast<page_id_t>(page_id + i);
+    shard_page_ids[static_cast<size_t>(next_page_id) % shards_.size()].push_back(next_page_id);
+  }
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    auto &shard = shards_[i];
+    std::lock_guard<std::mutex> guard(shard.latch_);
+    // Claim a frame and start the read for every missing page, then publish them once all reads are done.
+    std::vector<std::pair<page_id_t, frame_id_t>> loads;
+    std::vector<std::future<void>> reads;
+    for (auto next_page_id : shard_page_ids[i]) {
+      frame_id_t frame_id;
+      if (shard.page_table_->Find(next_page_id, &frame_id)) {
+        continue;
+      }
+      frame_id = get_free_page(&shard);
+      if (frame_id == -1) {
+        break;
+      }
+      auto &page = shard.pages_[frame_id];
+      page.pin_count_ = 1;
+      page.is_dirty_ = false;
+      page.ResetMemory();
+      if (shard.write_back_page_id_ == next_page_id) {
+        wait_write_back(&shard);
+      }
+      reads.push_back(disk_manager_->ReadPageAsync(next_page_id, page.data_));
+      loads.emplace_back(next_page_id, frame_id);
+    }
+    for (size_t j = 0; j < loads.size(); ++j) {
+      auto [loaded_page_id, frame_id] = loads[j];
+      auto &page = shard.pages_[frame_id];
+      try {
+        reads[j].get();
+      } catch (Exception &e) {
+        page.pin_count_ = 0;
+        shard.free_list_.push_back(frame_id);
+        continue;
+      }
+      page.clean_lsn_ = next_lsn();
+      page.page_id_ = loaded_page_id;
+      shard.page_table_->Insert(loaded_page_id, frame_id);
+      shard.num_misses_ += 1;
+      num_prefetched_pages_ += 1;
+      unpin_frame(&shard, frame_id);
+    }
   }
 }
 
@@ -15,65 +15,66 @@
 namespace bustub {
 
 ClockReplacer::ClockReplacer(size_t num_pages)
-    : clock_vector(decltype(clock_vector)(num_pages)),
-      ClockReplacer_frame_counter(0),
-      clock_hand(clock_vector.begin()) {}
-
-ClockReplacer::~ClockReplacer() = default;
-
-void ClockReplacer::move_clock_hand() {
-  if (clock_hand + 1 == clock_vector.end()) {
-    clock_hand = clock_vector.begin();
-  } else {
-    clock_hand += 1;
+    : num_words_((num_pages + BITS_PER_WORD - 1) / BITS_PER_WORD),
+      unpinned_(new std::atomic<uint64_t>[num_words_]),
+      ref_(new std::atomic<uint64_t>[num_words_]) {
+  for (size_t i = 0; i < num_words_; ++i) {
+    unpinned_[i] = 0;
+    ref_[i] = 0;
   }
 }
 
+ClockReplacer::~ClockReplacer() = default;
+
 auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool {
   std::lock_guard<std::mutex> lockGuard(latch_);
-  if (ClockReplacer_frame_counter == 0) {
+  if (num_words_ == 0) {
     return false;
   }
-  while (true) {
-    if ((!clock_hand->pin_flag) && (!clock_hand->ref_flag)) {
-      *frame_id = clock_hand - clock_vector.begin();
-      if (!((clock_vector.begin() + *frame_id)->pin_flag)) {
-        ClockReplacer_frame_counter -= 1;
+  // Two full turns of the hand: the first one may only clear reference bits. If nothing is found after that, every
+  // frame was pinned.
+  for (size_t step = 0; step <= 2 * num_words_; ++step) {
+    uint64_t from_hand = ~uint64_t{0} << hand_bit_;
+    uint64_t unpinned = unpinned_[hand_word_].load() & from_hand;
+    uint64_t candidates = unpinned & ~ref_[hand_word_].load();
+    if (candidates != 0) {
+      auto bit = static_cast<size_t>(__builtin_ctzll(candidates));
+      uint64_t mask = uint64_t{1} << bit;
+      // The frames the hand passes over get their second chance.
+      ref_[hand_word_].fetch_and(~(unpinned & (mask - 1)));
+      hand_bit_ = bit;
+      if ((unpinned_[hand_word_].fetch_and(~mask) & mask) != 0) {
+        *frame_id = static_cast<frame_id_t>(hand_word_ * BITS_PER_WORD + bit);
+        return true;
       }
-      (clock_vector.begin() + *frame_id)->pin_flag = true;
-      (clock_vector.begin() + *frame_id)->ref_flag = true;
-      break;
-    }
-    if ((!clock_hand->pin_flag) && (clock_hand->ref_flag)) {
-      clock_hand->ref_flag = false;
-      move_clock_hand();
-    } else {
-      move_clock_hand();
+      // The frame was pinned under our feet, look at this word again.
+      continue;
     }
+    ref_[hand_word_].fetch_and(~unpinned);
+    hand_bit_ = 0;
+    hand_word_ = hand_word_ + 1 == num_words_ ? 0 : hand_word_ + 1;
   }
-  return true;
+  return false;
 }
 
 void ClockReplacer::Pin(frame_id_t frame_id) {
-  std::lock_guard<std::mutex> lockGuard(latch_);
-  if (!((clock_vector.begin() + frame_id)->pin_flag)) {
-    ClockReplacer_frame_counter -= 1;
-  }
-  (clock_vector.begin() + frame_id)->pin_flag = true;
-  (clock_vector.begin() + frame_id)->ref_flag = true;
+  unpinned_[static_cast<size_t>(frame_id) / BITS_PER_WORD].fetch_and(~bit_of(frame_id));
 }
 
 void ClockReplacer::Unpin(frame_id_t frame_id) {
-  std::lock_guard<std::mutex> lockGuard(latch_);
-  if (((clock_vector.begin() + frame_id)->pin_flag)) {
-    ClockReplacer_frame_counter += 1;
-  }
-  (clock_vector.begin() + frame_id)->pin_flag = false;
+  // Set the reference bit first, so that the hand never sees the frame unpinned without it.
+  ref_[static_cast<size_t>(frame_id) / BITS_PER_WORD].fetch_or(bit_of(frame_id));
+  unpinned_[static_cast<size_t>(frame_id) / BITS_PER_WORD].fetch_or(bit_of(frame_id));
 }
 
+void ClockReplacer::Remove(frame_id_t frame_id) { Pin(frame_id); }
+
 auto ClockReplacer::Size() -> size_t {
-  std::lock_guard<std::mutex> lockGuard(latch_);
-  return ClockReplacer_frame_counter;
+  size_t size = 0;
+  for (size_t i = 0; i < num_words_; ++i) {
+    size += static_cast<size_t>(__builtin_popcountll(unpinned_[i].load()));
+  }
+  return size;
 }
 
 }  // namespace bustub
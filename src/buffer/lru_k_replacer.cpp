@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : frames_(num_pages), k_(k) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+auto LRUKReplacer::set_of(frame_id_t frame_id) -> std::set<entry> & {
+  return frames_[frame_id].history.size() < k_ ? history_set_ : cache_set_;
+}
+
+void LRUKReplacer::record_access(frame_id_t frame_id) {
+  auto &history = frames_[frame_id].history;
+  history.push_back(current_timestamp_++);
+  if (history.size() > k_) {
+    history.pop_front();
+  }
+}
+
+void LRUKReplacer::make_unevictable(frame_id_t frame_id) {
+  auto &frame = frames_[frame_id];
+  if (frame.evictable) {
+    set_of(frame_id).erase({frame.history.front(), frame_id});
+    frame.evictable = false;
+  }
+}
+
+auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> lockGuard(latch_);
+  auto &victims = history_set_.empty() ? cache_set_ : history_set_;
+  if (victims.empty()) {
+    return false;
+  }
+  *frame_id = victims.begin()->second;
+  victims.erase(victims.begin());
+  frames_[*frame_id].evictable = false;
+  frames_[*frame_id].history.clear();
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lockGuard(latch_);
+  make_unevictable(frame_id);
+  record_access(frame_id);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lockGuard(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable) {
+    return;
+  }
+  // A frame that was never pinned is treated as accessed now.
+  if (frame.history.empty()) {
+    record_access(frame_id);
+  }
+  frame.evictable = true;
+  set_of(frame_id).insert({frame.history.front(), frame_id});
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lockGuard(latch_);
+  make_unevictable(frame_id);
+  frames_[frame_id].history.clear();
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  std::lock_guard<std::mutex> lockGuard(latch_);
+  return history_set_.size() + cache_set_.size();
+}
+
+}  // namespace bustub
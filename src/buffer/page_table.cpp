@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) {
+  // Keep the load factor at or below one half so that probe sequences stay short.
+  size_t capacity = 2;
+  while (capacity < 2 * num_frames) {
+    capacity <<= 1;
+  }
+  mask_ = capacity - 1;
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity);
+  for (size_t i = 0; i < capacity; ++i) {
+    slots_[i].store(EMPTY, std::memory_order_relaxed);
+  }
+}
+
+auto PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const -> bool {
+  auto idx = Home(page_id);
+  for (size_t i = 0; i <= mask_; ++i) {
+    auto slot = slots_[idx].load(std::memory_order_acquire);
+    if (slot == EMPTY) {
+      return false;
+    }
+    if (slot != TOMBSTONE && PageIdOf(slot) == page_id) {
+      *frame_id = FrameIdOf(slot);
+      return true;
+    }
+    idx = (idx + 1) & mask_;
+  }
+  return false;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(size_ <= mask_ / 2, "PageTable holds more mappings than frames.");
+  auto idx = Home(page_id);
+  while (true) {
+    auto slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY || slot == TOMBSTONE) {
+      if (slot == TOMBSTONE) {
+        tombstones_ -= 1;
+      }
+      slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+      size_ += 1;
+      return;
+    }
+    idx = (idx + 1) & mask_;
+  }
+}
+
+void PageTable::Remove(page_id_t page_id) {
+  auto idx = Home(page_id);
+  for (size_t i = 0; i <= mask_; ++i) {
+    auto slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY) {
+      return;
+    }
+    if (slot != TOMBSTONE && PageIdOf(slot) == page_id) {
+      size_ -= 1;
+      // If the next slot is empty no probe sequence runs through this slot, so it can become empty as well.
+      if (slots_[(idx + 1) & mask_].load(std::memory_order_relaxed) == EMPTY) {
+        slots_[idx].store(EMPTY, std::memory_order_release);
+        return;
+      }
+      slots_[idx].store(TOMBSTONE, std::memory_order_release);
+      tombstones_ += 1;
+      if (tombstones_ > (mask_ + 1) / 4) {
+        Rehash();
+      }
+      return;
+    }
+    idx = (idx + 1) & mask_;
+  }
+}
+
+void PageTable::Rehash() {
+  std::vector<uint64_t> live;
+  live.reserve(size_);
+  for (size_t i = 0; i <= mask_; ++i) {
+    auto slot = slots_[i].load(std::memory_order_relaxed);
+    if (slot != EMPTY && slot != TOMBSTONE) {
+      live.push_back(slot);
+    }
+    slots_[i].store(EMPTY, std::memory_order_release);
+  }
+  size_ = 0;
+  tombstones_ = 0;
+  for (auto slot : live) {
+    Insert(PageIdOf(slot), FrameIdOf(slot));
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.cpp
+//
+// Identification: src/common/util/crc32c_util.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c_util.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** The CRC-32C polynomial, bit reversed. */
+constexpr uint32_t CRC32C_POLY = 0x82f63b78;
+
+/** Length of each of the three streams of the hardware implementation. */
+constexpr size_t CRC32C_STREAM_SIZE = 256;
+
+/** Multiply a vector by a 32x32 matrix over GF(2), the matrix is given by its columns. */
+uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  for (; vec != 0; vec >>= 1, mat++) {
+    if ((vec & 1) != 0) {
+      sum ^= *mat;
+    }
+  }
+  return sum;
+}
+
+void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = Gf2MatrixTimes(mat, mat[n]);
+  }
+}
+
+/**
+ * Lookup tables used by the software implementation, and to shift a CRC over a run of zero bytes, which is how the
+ * CRCs of consecutive streams are combined.
+ */
+struct Crc32cTables {
+  uint32_t bytes_[256];
+  uint32_t shift_[4][256];
+
+  Crc32cTables() {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t crc = n;
+      for (int k = 0; k < 8; k++) {
+        crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+      }
+      bytes_[n] = crc;
+    }
+
+    // Build the operator that appends CRC32C_STREAM_SIZE zero bytes by repeated squaring, starting from the operator
+    // for a single zero bit. The stream size is a power of two.
+    uint32_t odd[32];
+    uint32_t even[32];
+    odd[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; n++) {
+      odd[n] = uint32_t{1} << (n - 1);
+    }
+    Gf2MatrixSquare(even, odd);  // 2 zero bits
+    Gf2MatrixSquare(odd, even);  // 4 zero bits
+    uint32_t *op = odd;
+    for (size_t len = CRC32C_STREAM_SIZE; len != 0; len >>= 1) {
+      uint32_t *other = op == odd ? even : odd;
+      Gf2MatrixSquare(other, op);
+      op = other;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      shift_[0][n] = Gf2MatrixTimes(op, n);
+      shift_[1][n] = Gf2MatrixTimes(op, n << 8);
+      shift_[2][n] = Gf2MatrixTimes(op, n << 16);
+      shift_[3][n] = Gf2MatrixTimes(op, n << 24);
+    }
+  }
+
+  /** @return the CRC after appending CRC32C_STREAM_SIZE zero bytes (without pre and post conditioning) */
+  uint32_t Shift(uint32_t crc) const {
+    return shift_[0][crc & 0xff] ^ shift_[1][(crc >> 8) & 0xff] ^ shift_[2][(crc >> 16) & 0xff] ^
+           shift_[3][crc >> 24];
+  }
+};
+
+const Crc32cTables CRC32C_TABLES;
+
+}  // namespace
+
+uint32_t Crc32cUtil::Crc32c(const char *data, size_t size, uint32_t crc) {
+  static const bool has_hardware_support = HasHardwareSupport();
+  return has_hardware_support ? Crc32cHardware(data, size, crc) : Crc32cPortable(data, size, crc);
+}
+
+uint32_t Crc32cUtil::Crc32cPortable(const char *data, size_t size, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc = CRC32C_TABLES.bytes_[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+bool Crc32cUtil::HasHardwareSupport() {
+#if defined(__x86_64__)
+  return __builtin_cpu_supports("sse4.2");
+#else
+  return false;
+#endif
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t Crc32cUtil::Crc32cHardware(const char *data, size_t size, uint32_t crc) {
+  uint64_t crc0 = ~crc;
+  while (size > 0 && reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+    crc0 = _mm_crc32_u8(crc0, *data++);
+    size--;
+  }
+  // The crc32 instruction has a latency of three cycles but can start every cycle: checksum three independent streams
+  // and shift the first two over the bytes of the following ones to combine them.
+  while (size >= 3 * CRC32C_STREAM_SIZE) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (const char *end = data + CRC32C_STREAM_SIZE; data < end; data += 8) {
+      uint64_t words[3];
+      memcpy(&words[0], data, 8);
+      memcpy(&words[1], data + CRC32C_STREAM_SIZE, 8);
+      memcpy(&words[2], data + 2 * CRC32C_STREAM_SIZE, 8);
+      crc0 = _mm_crc32_u64(crc0, words[0]);
+      crc1 = _mm_crc32_u64(crc1, words[1]);
+      crc2 = _mm_crc32_u64(crc2, words[2]);
+    }
+    crc0 = CRC32C_TABLES.Shift(crc0) ^ crc1;
+    crc0 = CRC32C_TABLES.Shift(crc0) ^ crc2;
+    data += 2 * CRC32C_STREAM_SIZE;
+    size -= 3 * CRC32C_STREAM_SIZE;
+  }
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+    crc0 = _mm_crc32_u64(crc0, word);
+  }
+  for (; size > 0; size--) {
+    crc0 = _mm_crc32_u8(crc0, *data++);
+  }
+  return ~static_cast<uint32_t>(crc0);
+}
+#else
+uint32_t Crc32cUtil::Crc32cHardware(const char *data, size_t size, uint32_t crc) {
+  return Crc32cPortable(data, size, crc);
+}
+#endif
+
+}  // namespace bustub
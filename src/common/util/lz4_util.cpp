@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_util.cpp
+//
+// Identification: src/common/util/lz4_util.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz4_util.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+// The format requires the last 5 bytes to be literals, and the last match to start 12 bytes before the end.
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MF_LIMIT = 12;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_LOG = 12;
+// Every 2^SKIP_TRIGGER failed searches, the compressor moves one more byte ahead, to get over incompressible data.
+constexpr int SKIP_TRIGGER = 6;
+
+uint32_t Read32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_LOG); }
+
+/** Write a length that did not fit in the token: runs of 255 followed by the remainder. */
+uint8_t *WriteLength(uint8_t *op, size_t length) {
+  for (; length >= 255; length -= 255) {
+    *op++ = 255;
+  }
+  *op++ = static_cast<uint8_t>(length);
+  return op;
+}
+
+/** Read the continuation of a length, returns false if the input ends first. */
+bool ReadLength(const uint8_t **ip, const uint8_t *iend, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*ip >= iend) {
+      return false;
+    }
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Emit a sequence of literals followed by a match (no match if match_length is 0 and offset is 0). */
+bool EmitSequence(uint8_t **op, uint8_t *oend, const uint8_t *literals, size_t literal_length, size_t offset,
+                  size_t match_length) {
+  // token, length continuations, literals, offset
+  size_t worst_case = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+  if (static_cast<size_t>(oend - *op) < worst_case) {
+    return false;
+  }
+  uint8_t *out = *op;
+  uint8_t *token = out++;
+  *token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+  if (literal_length >= 15) {
+    out = WriteLength(out, literal_length - 15);
+  }
+  memcpy(out, literals, literal_length);
+  out += literal_length;
+  if (offset != 0) {
+    *out++ = static_cast<uint8_t>(offset);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    *token |= static_cast<uint8_t>(match_length < 15 ? match_length : 15);
+    if (match_length >= 15) {
+      out = WriteLength(out, match_length - 15);
+    }
+  }
+  *op = out;
+  return true;
+}
+
+}  // namespace
+
+size_t Lz4Util::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  const auto *base = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *ip = base;
+  const uint8_t *anchor = base;
+  const uint8_t *end = base + src_size;
+  auto *op = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *oend = op + dst_capacity;
+
+  if (src_size >= MF_LIMIT + 1) {
+    const uint8_t *mf_limit = end - MF_LIMIT;
+    const uint8_t *match_limit = end - LAST_LITERALS;
+    uint32_t table[1 << HASH_LOG];
+    // Positions are stored relative to base, the entries start pointing at byte 0 which is verified like any other.
+    memset(table, 0, sizeof(table));
+    unsigned searches = 1 << SKIP_TRIGGER;
+    ip++;
+    while (ip < mf_limit) {
+      uint32_t sequence = Read32(ip);
+      uint32_t hash = Hash(sequence);
+      const uint8_t *ref = base + table[hash];
+      table[hash] = static_cast<uint32_t>(ip - base);
+      if (static_cast<size_t>(ip - ref) > MAX_OFFSET || Read32(ref) != sequence) {
+        ip += searches++ >> SKIP_TRIGGER;
+        continue;
+      }
+      searches = 1 << SKIP_TRIGGER;
+      // Extend the match backwards over the pending literals, then forwards.
+      while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+        ip--;
+        ref--;
+      }
+      const uint8_t *match_end = ip + MIN_MATCH;
+      const uint8_t *ref_end = ref + MIN_MATCH;
+      while (match_end < match_limit && *match_end == *ref_end) {
+        match_end++;
+        ref_end++;
+      }
+      if (!EmitSequence(&op, oend, anchor, ip - anchor, ip - ref, match_end - ip - MIN_MATCH)) {
+        return 0;
+      }
+      ip = match_end;
+      anchor = ip;
+      if (ip < mf_limit) {
+        table[Hash(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+      }
+    }
+  }
+  if (!EmitSequence(&op, oend, anchor, end - anchor, 0, 0)) {
+    return 0;
+  }
+  return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+bool Lz4Util::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) {
+  const auto *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *iend = ip + src_size;
+  auto *base = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *op = base;
+  uint8_t *oend = base + dst_size;
+  while (true) {
+    if (ip >= iend) {
+      return false;
+    }
+    uint8_t token = *ip++;
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(&ip, iend, &literal_length)) {
+      return false;
+    }
+    if (literal_length > static_cast<size_t>(iend - ip) || literal_length > static_cast<size_t>(oend - op)) {
+      return false;
+    }
+    memcpy(op, ip, literal_length);
+    op += literal_length;
+    ip += literal_length;
+    // The last sequence has no match.
+    if (ip == iend) {
+      break;
+    }
+    if (iend - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - base)) {
+      return false;
+    }
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(&ip, iend, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (match_length > static_cast<size_t>(oend - op)) {
+      return false;
+    }
+    const uint8_t *match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      // The match overlaps the bytes it produces, e.g. a run of one repeated byte.
+      for (size_t i = 0; i < match_length; i++) {
+        *op++ = *match++;
+      }
+    }
+  }
+  return op == oend;
+}
+
+}  // namespace bustub
@@ -0,0 +1,44 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varint_util.cpp
+//
+// Identification: src/common/util/varint_util.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/varint_util.h"
+
+namespace bustub {
+
+size_t VarintUtil::Encode(uint64_t value, char *data) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    data[size++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  data[size++] = static_cast<char>(value);
+  return size;
+}
+
+size_t VarintUtil::Decode(const char *data, size_t available, uint64_t *value) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < available && i < MAX_SIZE; i++) {
+    auto byte = static_cast<uint8_t>(data[i]);
+    // The tenth byte holds the highest bit only.
+    if (i == MAX_SIZE - 1 && byte > 1) {
+      return 0;
+    }
+    result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #include "concurrency/transaction_manager.h"
 
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
 
@@ -20,6 +21,7 @@
 namespace bustub {
 
 std::unordered_map<txn_id_t, Transaction *> TransactionManager::txn_map = {};
+std::mutex TransactionManager::txn_map_latch;
 
 Transaction *TransactionManager::Begin(Transaction *txn) {
   // Acquire the global transaction latch in shared mode.
@@ -30,9 +32,13 @@ Transaction *TransactionManager::Begin(Transaction *txn) {
   }
 
   if (enable_logging) {
-    // TODO(student): Add logging here.
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+    std::lock_guard<std::mutex> guard(active_txns_latch_);
+    active_txns_[txn->GetTransactionId()] = txn->GetPrevLSN();
   }
 
+  std::lock_guard<std::mutex> guard(txn_map_latch);
   txn_map[txn->GetTransactionId()] = txn;
   return txn;
 }
@@ -54,7 +60,14 @@ void TransactionManager::Commit(Transaction *txn) {
   write_set->clear();
 
   if (enable_logging) {
-    // TODO(student): add logging here
+    // The commit is durable once its record is. Concurrent commits share the flush that writes their records.
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+    log_manager_->Flush(txn->GetPrevLSN());
+  }
+  {
+    std::lock_guard<std::mutex> guard(active_txns_latch_);
+    active_txns_.erase(txn->GetTransactionId());
   }
 
   // Release all the locks.
@@ -84,7 +97,12 @@ void TransactionManager::Abort(Transaction *txn) {
   write_set->clear();
 
   if (enable_logging) {
-    // TODO(student): add logging here
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+  {
+    std::lock_guard<std::mutex> guard(active_txns_latch_);
+    active_txns_.erase(txn->GetTransactionId());
   }
 
   // Release all the locks.
@@ -93,6 +111,18 @@ void TransactionManager::Abort(Transaction *txn) {
   global_txn_latch_.RUnlock();
 }
 
+lsn_t TransactionManager::GetActiveTransactions(std::vector<std::pair<txn_id_t, lsn_t>> *active_txn_table) {
+  std::lock_guard<std::mutex> guard(active_txns_latch_);
+  lsn_t min_lsn = INVALID_LSN;
+  for (const auto &[txn_id, begin_lsn] : active_txns_) {
+    active_txn_table->emplace_back(txn_id, begin_lsn);
+    if (min_lsn == INVALID_LSN || begin_lsn < min_lsn) {
+      min_lsn = begin_lsn;
+    }
+  }
+  return min_lsn;
+}
+
 void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
@@ -0,0 +1,357 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table.cpp
+//
+// Identification: src/container/hash/extendible_hash_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/extendible_hash_table.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/rid.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+EXTENDIBLE_HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  auto *dir = reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPage(&directory_page_id_)->GetData());
+  *dir = HashTableDirectoryPage();
+  dir->SetPageId(directory_page_id_);
+
+  page_id_t bucket_page_id;
+  auto *bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->NewPage(&bucket_page_id)->GetData());
+  bucket->Clear();
+  dir->SetBucketPageId(0, bucket_page_id);
+  dir->SetLocalDepth(0, 0);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+EXTENDIBLE_HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                                page_id_t directory_page_id)
+    : directory_page_id_(directory_page_id),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableDirectoryPage *EXTENDIBLE_HASH_TABLE_TYPE::fetch_directory() {
+  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::key_to_directory_index(const KeyType &key, HashTableDirectoryPage *dir) {
+  return static_cast<uint32_t>(hash_fn_.GetHash(key)) & dir->GetGlobalDepthMask();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visit>
+void EXTENDIBLE_HASH_TABLE_TYPE::visit_chain(page_id_t bucket_page_id, Visit &&visit) {
+  for (auto page_id = bucket_page_id; page_id != INVALID_PAGE_ID;) {
+    auto *bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(page_id)->GetData());
+    bool dirty = false;
+    bool more = visit(bucket, &dirty);
+    auto next_page_id = bucket->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, dirty);
+    if (!more) {
+      break;
+    }
+    page_id = next_page_id;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::chain_contains(page_id_t bucket_page_id, const KeyType &key, const ValueType &value) {
+  bool found = false;
+  visit_chain(bucket_page_id, [this, &key, &value, &found](HASH_TABLE_BUCKET_TYPE *bucket, bool *dirty) {
+    std::vector<ValueType> values;
+    bucket->GetValue(key, comparator_, &values);
+    found = std::find(values.begin(), values.end(), value) != values.end();
+    return !found;
+  });
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::chain_insert(page_id_t bucket_page_id, const KeyType &key, const ValueType &value,
+                                              bool overflow) {
+  bool inserted = false;
+  visit_chain(bucket_page_id,
+              [this, &key, &value, overflow, &inserted](HASH_TABLE_BUCKET_TYPE *bucket, bool *dirty) {
+                if (!bucket->IsFull()) {
+                  inserted = bucket->Insert(key, value, comparator_);
+                } else if (overflow && bucket->GetNextPageId() == INVALID_PAGE_ID) {
+                  page_id_t next_page_id;
+                  auto *next = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(
+                      buffer_pool_manager_->NewPage(&next_page_id)->GetData());
+                  next->Clear();
+                  inserted = next->Insert(key, value, comparator_);
+                  buffer_pool_manager_->UnpinPage(next_page_id, true);
+                  bucket->SetNextPageId(next_page_id);
+                }
+                *dirty = inserted;
+                return !inserted;
+              });
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::drop_empty_overflow_pages(page_id_t bucket_page_id) {
+  std::vector<page_id_t> empty_page_ids;
+  visit_chain(bucket_page_id, [this, &empty_page_ids](HASH_TABLE_BUCKET_TYPE *bucket, bool *dirty) {
+    // Unlink the empty pages that follow this one, the page itself is unlinked by its predecessor.
+    while (bucket->GetNextPageId() != INVALID_PAGE_ID) {
+      auto next_page_id = bucket->GetNextPageId();
+      auto *next = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(next_page_id)->GetData());
+      bool empty = next->IsEmpty();
+      if (empty) {
+        bucket->SetNextPageId(next->GetNextPageId());
+        empty_page_ids.push_back(next_page_id);
+        *dirty = true;
+      }
+      buffer_pool_manager_->UnpinPage(next_page_id, false);
+      if (!empty) {
+        break;
+      }
+    }
+    return true;
+  });
+  for (auto page_id : empty_page_ids) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::chain_is_empty(page_id_t bucket_page_id) {
+  auto *bucket =
+      reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(bucket_page_id)->GetData());
+  bool empty = bucket->IsEmpty() && bucket->GetNextPageId() == INVALID_PAGE_ID;
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  return empty;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                          std::vector<ValueType> *result) {
+  table_latch_.RLock();
+  auto *dir = fetch_directory();
+  auto bucket_page_id = dir->GetBucketPageId(key_to_directory_index(key, dir));
+  auto *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  // The latch of the first page of a bucket covers its overflow pages.
+  page->RLatch();
+  bool found = false;
+  visit_chain(bucket_page_id, [this, &key, result, &found](HASH_TABLE_BUCKET_TYPE *bucket, bool *dirty) {
+    found = bucket->GetValue(key, comparator_, result) || found;
+    return true;
+  });
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  auto *dir = fetch_directory();
+  auto bucket_page_id = dir->GetBucketPageId(key_to_directory_index(key, dir));
+  auto *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  page->WLatch();
+  bool exists = chain_contains(bucket_page_id, key, value);
+  bool inserted = !exists && chain_insert(bucket_page_id, key, value, false);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (exists || inserted) {
+    return inserted;
+  }
+  return split_insert(key, value);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::split_insert(const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  auto *dir = fetch_directory();
+  bool dir_dirty = false;
+  bool inserted;
+  auto hash = static_cast<uint32_t>(hash_fn_.GetHash(key));
+  // The bucket may still be full after a split if all of its keys went to the same side.
+  while (true) {
+    auto bucket_idx = hash & dir->GetGlobalDepthMask();
+    auto bucket_page_id = dir->GetBucketPageId(bucket_idx);
+    if (chain_contains(bucket_page_id, key, value)) {
+      inserted = false;
+      break;
+    }
+    if (chain_insert(bucket_page_id, key, value, false)) {
+      inserted = true;
+      break;
+    }
+
+    // Splitting only helps if a key of the bucket differs from the new one in the hash bits the directory can still
+    // use, otherwise the bucket overflows into a new page.
+    auto local_depth = dir->GetLocalDepth(bucket_idx);
+    auto split_mask = (HashTableDirectoryPage::MaxSize() - 1) & ~((1U << local_depth) - 1);
+    bool splittable = false;
+    visit_chain(bucket_page_id, [this, hash, split_mask, &splittable](HASH_TABLE_BUCKET_TYPE *bucket, bool *dirty) {
+      for (uint32_t i = 0; i < bucket->SlotsNum() && !splittable; i++) {
+        splittable = bucket->IsReadable(i) &&
+                     ((static_cast<uint32_t>(hash_fn_.GetHash(bucket->KeyAt(i))) ^ hash) & split_mask) != 0;
+      }
+      return !splittable;
+    });
+    if (!splittable) {
+      inserted = chain_insert(bucket_page_id, key, value, true);
+      break;
+    }
+
+    if (local_depth == dir->GetGlobalDepth()) {
+      BUSTUB_ASSERT(dir->Size() * 2 <= HashTableDirectoryPage::MaxSize(), "A splittable bucket has a free hash bit.");
+      dir->IncrGlobalDepth();
+    }
+
+    // The entries whose hash has the next bit set move to the split image, which overflows if they all do.
+    page_id_t image_page_id;
+    auto *image = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->NewPage(&image_page_id)->GetData());
+    image->Clear();
+    buffer_pool_manager_->UnpinPage(image_page_id, true);
+    auto high_bit = 1U << local_depth;
+    visit_chain(bucket_page_id, [this, high_bit, image_page_id](HASH_TABLE_BUCKET_TYPE *bucket, bool *dirty) {
+      for (uint32_t i = 0; i < bucket->SlotsNum(); i++) {
+        if (bucket->IsReadable(i) && (static_cast<uint32_t>(hash_fn_.GetHash(bucket->KeyAt(i))) & high_bit) != 0) {
+          chain_insert(image_page_id, bucket->KeyAt(i), bucket->ValueAt(i), true);
+          bucket->RemoveAt(i);
+          *dirty = true;
+        }
+      }
+      return true;
+    });
+    drop_empty_overflow_pages(bucket_page_id);
+    auto local_mask = (1U << local_depth) - 1;
+    for (uint32_t i = 0; i < dir->Size(); i++) {
+      if ((i & local_mask) == (bucket_idx & local_mask)) {
+        dir->SetLocalDepth(i, local_depth + 1);
+        if ((i & high_bit) != 0) {
+          dir->SetBucketPageId(i, image_page_id);
+        }
+      }
+    }
+    dir_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  auto *dir = fetch_directory();
+  auto bucket_page_id = dir->GetBucketPageId(key_to_directory_index(key, dir));
+  auto *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  page->WLatch();
+  bool removed = false;
+  visit_chain(bucket_page_id, [this, &key, &value, &removed](HASH_TABLE_BUCKET_TYPE *bucket, bool *dirty) {
+    removed = bucket->Remove(key, value, comparator_);
+    *dirty = removed;
+    return !removed;
+  });
+  if (removed) {
+    drop_empty_overflow_pages(bucket_page_id);
+  }
+  bool empty = chain_is_empty(bucket_page_id);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (removed && empty) {
+    merge(key);
+  }
+  return removed;
+}
+
+/*****************************************************************************
+ * MERGE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::merge(const KeyType &key) {
+  table_latch_.WLock();
+  auto *dir = fetch_directory();
+  bool dir_dirty = false;
+  while (true) {
+    auto bucket_idx = key_to_directory_index(key, dir);
+    auto local_depth = dir->GetLocalDepth(bucket_idx);
+    auto image_idx = dir->GetSplitImageIndex(bucket_idx);
+    if (local_depth == 0 || dir->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+    // An insert may have refilled the bucket before the write latch was taken.
+    auto bucket_page_id = dir->GetBucketPageId(bucket_idx);
+    if (!chain_is_empty(bucket_page_id)) {
+      break;
+    }
+
+    auto image_page_id = dir->GetBucketPageId(image_idx);
+    for (uint32_t i = 0; i < dir->Size(); i++) {
+      if (dir->GetBucketPageId(i) == bucket_page_id || dir->GetBucketPageId(i) == image_page_id) {
+        dir->SetBucketPageId(i, image_page_id);
+        dir->SetLocalDepth(i, local_depth - 1);
+      }
+    }
+    buffer_pool_manager_->DeletePage(bucket_page_id);
+    while (dir->CanShrink()) {
+      dir->DecrGlobalDepth();
+    }
+    dir_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+}
+
+/*****************************************************************************
+ * GETGLOBALDEPTH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::GetGlobalDepth() {
+  table_latch_.RLock();
+  auto global_depth = fetch_directory()->GetGlobalDepth();
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return global_depth;
+}
+
+template class ExtendibleHashTable<int, int, IntComparator>;
+
+template class ExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
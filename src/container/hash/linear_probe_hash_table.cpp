@@ -12,77 +12,210 @@
 
 #include "container/hash/linear_probe_hash_table.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "common/exception.h"
 #include "common/logger.h"
 #include "common/rid.h"
 
 namespace bustub {
 
+namespace {
+
+/** @return a mask of the first num_slots slots of a group, as returned by MatchTag */
+uint32_t GroupMask(size_t num_slots) { return num_slots >= 32 ? UINT32_MAX : (uint32_t{1} << num_slots) - 1; }
+
+/** @return a mask of the slots of a group before its first vacant slot, where the probe sequence ends */
+uint32_t ProbedMask(uint32_t vacant, size_t num_slots) {
+  return vacant == 0 ? GroupMask(num_slots) : (vacant & (~vacant + 1)) - 1;
+}
+
+}  // namespace
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::get_bucket_id_value(u_int64_t prob, const KeyType &key, std::vector<ValueType> *result) {
-  auto *hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id_)->GetData());
-  auto block_page_id = hp->GetBlockPageId(prob / BLOCK_ARRAY_SIZE);
-  auto *bp = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
-  auto slot_index = prob % BLOCK_ARRAY_SIZE;
-  if (!bp->IsOccupied(slot_index)) {
-    buffer_pool_manager_->UnpinPage(header_page_id_, false);
-    buffer_pool_manager_->UnpinPage(block_page_id, false);
-    return false;
+template <typename Visit>
+void HASH_TABLE_TYPE::probe(const std::vector<page_id_t> &block_page_ids, uint64_t hash, bool exclusive,
+                            Visit &&visit) {
+  auto size = block_page_ids.size() * BLOCK_ARRAY_SIZE;
+  auto prob = hash % size;
+  Page *page = nullptr;
+  size_t block_index = SIZE_MAX;
+  bool dirty = false;
+  auto release = [this, exclusive](Page *page, bool dirty) {
+    if (exclusive) {
+      page->WUnlatch();
+    } else {
+      page->RUnlatch();
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+  };
+  for (size_t i = 0; i < size;) {
+    if (prob / BLOCK_ARRAY_SIZE != block_index) {
+      // The latches are taken in block order: the last block is released before wrapping around to the first one.
+      if (page != nullptr && prob == 0) {
+        release(page, dirty);
+        page = nullptr;
+      }
+      block_index = prob / BLOCK_ARRAY_SIZE;
+      auto *next_page = buffer_pool_manager_->FetchPage(block_page_ids[block_index]);
+      if (exclusive) {
+        next_page->WLatch();
+      } else {
+        next_page->RLatch();
+      }
+      if (page != nullptr) {
+        release(page, dirty);
+      }
+      page = next_page;
+      dirty = false;
+    }
+    // A group of slots ends at the end of the block and of the probe sequence.
+    auto slot_index = prob % BLOCK_ARRAY_SIZE;
+    auto num_slots = std::min<size_t>({HASH_TABLE_BLOCK_TYPE::TAG_GROUP_SIZE, BLOCK_ARRAY_SIZE - slot_index, size - i});
+    auto *bp = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    if (!visit(bp, slot_index, num_slots, &dirty)) {
+      break;
+    }
+    i += num_slots;
+    prob = (prob + num_slots) % size;
   }
-  if (bp->IsReadable(slot_index) && comparator_(key, bp->KeyAt(slot_index)) == 0) {
-    result->push_back(bp->ValueAt(slot_index));
+  if (page != nullptr) {
+    release(page, dirty);
   }
-  buffer_pool_manager_->UnpinPage(header_page_id_, false);
-  buffer_pool_manager_->UnpinPage(block_page_id, false);
-  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-int HASH_TABLE_TYPE::insert_bucket_id_kv(u_int64_t prob, const KeyType &key, const ValueType &value) {
-  auto *hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id_)->GetData());
-  auto block_page_id = hp->GetBlockPageId(prob / BLOCK_ARRAY_SIZE);
-  auto *bp = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
-  auto slot_index = prob % BLOCK_ARRAY_SIZE;
-  if (bp->IsReadable(slot_index) && comparator_(key, bp->KeyAt(slot_index)) == 0 && bp->ValueAt(slot_index) == value) {
-    buffer_pool_manager_->UnpinPage(header_page_id_, false);
-    buffer_pool_manager_->UnpinPage(block_page_id, false);
-    return 0;
+Page *HASH_TABLE_TYPE::latch_header(bool exclusive) {
+  auto *page = buffer_pool_manager_->FetchPage(header_page_id_);
+  if (exclusive) {
+    page->WLatch();
+  } else {
+    page->RLatch();
   }
-  if (bp->Insert(slot_index, key, value)) {
-    buffer_pool_manager_->UnpinPage(header_page_id_, false);
-    buffer_pool_manager_->UnpinPage(block_page_id, true);
-    return 1;
-  }
-  buffer_pool_manager_->UnpinPage(header_page_id_, false);
-  buffer_pool_manager_->UnpinPage(block_page_id, false);
-  return -1;
+  return page;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-int HASH_TABLE_TYPE::remove_bucket_id_kv(u_int64_t prob, const KeyType &key, const ValueType &value) {
-  auto *hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id_)->GetData());
-  auto block_page_id = hp->GetBlockPageId(prob / BLOCK_ARRAY_SIZE);
-  auto *bp = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
-  auto slot_index = prob % BLOCK_ARRAY_SIZE;
-  if (!bp->IsOccupied(slot_index)) {
-    buffer_pool_manager_->UnpinPage(header_page_id_, false);
-    buffer_pool_manager_->UnpinPage(block_page_id, false);
-    return -1;
+void HASH_TABLE_TYPE::unlatch_header(Page *page, bool exclusive) {
+  if (exclusive) {
+    page->WUnlatch();
+  } else {
+    page->RUnlatch();
   }
-  if (bp->IsReadable(slot_index) && comparator_(key, bp->KeyAt(slot_index)) == 0 && bp->ValueAt(slot_index) == value) {
-    bp->Remove(slot_index);
-    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  buffer_pool_manager_->UnpinPage(header_page_id_, exclusive);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::get_values(const std::vector<page_id_t> &block_page_ids, const KeyType &key,
+                                 std::vector<ValueType> *result) {
+  auto hash = hash_fn_.GetHash(key);
+  auto tag = HASH_TABLE_BLOCK_TYPE::HashTag(hash);
+  probe(block_page_ids, hash, false,
+        [this, &key, tag, result](HASH_TABLE_BLOCK_TYPE *bp, slot_offset_t slot_index, size_t num_slots, bool *dirty) {
+          // The probe sequence ends at the first slot that was never occupied.
+          auto vacant = bp->MatchTag(slot_index, HASH_TABLE_BLOCK_TYPE::EMPTY_TAG) & GroupMask(num_slots);
+          auto hits = bp->MatchTag(slot_index, tag) & ProbedMask(vacant, num_slots);
+          for (; hits != 0; hits &= hits - 1) {
+            auto hit_index = slot_index + __builtin_ctz(hits);
+            if (bp->IsReadable(hit_index) && comparator_(key, bp->KeyAt(hit_index)) == 0) {
+              result->push_back(bp->ValueAt(hit_index));
+            }
+          }
+          return vacant == 0;
+        });
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int HASH_TABLE_TYPE::insert_kv(const std::vector<page_id_t> &block_page_ids, const KeyType &key,
+                               const ValueType &value) {
+  int status = -1;  // -1代表没有插入，1代表成功插入，0代表该kv已经存在
+  auto hash = hash_fn_.GetHash(key);
+  auto tag = HASH_TABLE_BLOCK_TYPE::HashTag(hash);
+  probe(block_page_ids, hash, true,
+        [this, &key, &value, tag, &status](HASH_TABLE_BLOCK_TYPE *bp, slot_offset_t slot_index, size_t num_slots,
+                                           bool *dirty) {
+          // The pair goes to the first slot that is not readable, the keys before it are compared on tag hits only.
+          auto hits = bp->MatchTag(slot_index, tag);
+          for (size_t i = 0; i < num_slots; i++) {
+            if ((hits >> i & 1) != 0 && bp->IsReadable(slot_index + i) &&
+                comparator_(key, bp->KeyAt(slot_index + i)) == 0 && bp->ValueAt(slot_index + i) == value) {
+              status = 0;
+              return false;
+            }
+            if (bp->Insert(slot_index + i, key, value, tag)) {
+              status = 1;
+              *dirty = true;
+              return false;
+            }
+          }
+          return true;
+        });
+  return status;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::remove_kv(const std::vector<page_id_t> &block_page_ids, const KeyType &key,
+                                const ValueType &value) {
+  int status = 0;  // -1代表找不到该kv，0代表还未找到该kv，1代表找到该kv并删除
+  auto hash = hash_fn_.GetHash(key);
+  auto tag = HASH_TABLE_BLOCK_TYPE::HashTag(hash);
+  probe(block_page_ids, hash, true,
+        [this, &key, &value, tag, &status](HASH_TABLE_BLOCK_TYPE *bp, slot_offset_t slot_index, size_t num_slots,
+                                           bool *dirty) {
+          auto vacant = bp->MatchTag(slot_index, HASH_TABLE_BLOCK_TYPE::EMPTY_TAG) & GroupMask(num_slots);
+          auto hits = bp->MatchTag(slot_index, tag) & ProbedMask(vacant, num_slots);
+          for (; hits != 0; hits &= hits - 1) {
+            auto hit_index = slot_index + __builtin_ctz(hits);
+            if (bp->IsReadable(hit_index) && comparator_(key, bp->KeyAt(hit_index)) == 0 &&
+                bp->ValueAt(hit_index) == value) {
+              bp->Remove(hit_index);
+              status = 1;
+              *dirty = true;
+              return false;
+            }
+          }
+          if (vacant != 0) {
+            status = -1;
+          }
+          return status == 0;
+        });
+  return status == 1;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t HASH_TABLE_TYPE::new_block_array(size_t num_buckets, std::vector<page_id_t> *block_page_ids) {
+  page_id_t hp_id;
+  auto *hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->NewPage(&hp_id)->GetData());
+  *hp = HashTableHeaderPage();
+  hp->SetPageId(hp_id);
+  hp->SetSize(num_buckets);
+  // The block page ids are appended to the last page of the block directory.
+  auto *dp = hp;
+  page_id_t dp_id = hp_id;
+  for (size_t num_blocks = 0; num_blocks * BLOCK_ARRAY_SIZE < num_buckets; num_blocks++) {
+    if (dp->NumBlocks() == HashTableHeaderPage::MaxNumBlocks()) {
+      page_id_t next_dp_id;
+      auto *next_dp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->NewPage(&next_dp_id)->GetData());
+      *next_dp = HashTableHeaderPage();
+      next_dp->SetPageId(next_dp_id);
+      dp->SetNextPageId(next_dp_id);
+      buffer_pool_manager_->UnpinPage(dp_id, true);
+      dp = next_dp;
+      dp_id = next_dp_id;
+    }
+    page_id_t block_page_id;
+    auto *bp = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->NewPage(&block_page_id)->GetData());
+    bp->Clear();
+    dp->AddBlockPageId(block_page_id);
+    block_page_ids->push_back(block_page_id);
     buffer_pool_manager_->UnpinPage(block_page_id, true);
-    return 1;
   }
-  buffer_pool_manager_->UnpinPage(header_page_id_, false);
-  buffer_pool_manager_->UnpinPage(block_page_id, false);
-  return 0;
+  buffer_pool_manager_->UnpinPage(dp_id, true);
+  return hp_id;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -90,11 +223,49 @@ HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  auto *hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->NewPage(&header_page_id_)->GetData());
-  *hp = HashTableHeaderPage();
-  hp->SetPageId(header_page_id_);
-  buffer_pool_manager_->UnpinPage(header_page_id_, true);
-  Resize(num_buckets / 2 + 1);
+  header_page_id_ = new_block_array(std::max<size_t>(num_buckets, 1), &block_page_ids_);
+  size_ = block_page_ids_.size() * BLOCK_ARRAY_SIZE;
+  // A new table is empty.
+  std::call_once(count_once_, [] {});
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                      page_id_t header_page_id)
+    : header_page_id_(header_page_id),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {
+  auto *header_page = latch_header(false);
+  auto *hp = reinterpret_cast<HashTableHeaderPage *>(header_page->GetData());
+  load_block_page_ids(hp, &block_page_ids_);
+  auto old_hp_id = hp->GetOldHeaderPageId();
+  if (old_hp_id != INVALID_PAGE_ID) {
+    auto *old_hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(old_hp_id)->GetData());
+    load_block_page_ids(old_hp, &old_block_page_ids_);
+    buffer_pool_manager_->UnpinPage(old_hp_id, false);
+  }
+  size_ = block_page_ids_.size() * BLOCK_ARRAY_SIZE;
+  unlatch_header(header_page, false);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::load_block_page_ids(HashTableHeaderPage *hp, std::vector<page_id_t> *block_page_ids) {
+  block_page_ids->clear();
+  for (decltype(hp->NumBlocks()) i = 0; i < hp->NumBlocks(); i++) {
+    block_page_ids->push_back(hp->GetBlockPageId(i));
+  }
+  // The pages after the header page only change before the block array is installed, the header latch covers them.
+  for (auto dp_id = hp->GetNextPageId(); dp_id != INVALID_PAGE_ID;) {
+    auto *dp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(dp_id)->GetData());
+    for (decltype(dp->NumBlocks()) i = 0; i < dp->NumBlocks(); i++) {
+      block_page_ids->push_back(dp->GetBlockPageId(i));
+    }
+    auto next_dp_id = dp->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(dp_id, false);
+    dp_id = next_dp_id;
+  }
 }
 
 /*****************************************************************************
@@ -102,19 +273,15 @@ HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  table_latch_.RLock();
-
-  auto bucket_id = hash_fn_.GetHash(key) % GetSize();
-  auto prob = bucket_id;
+  auto *header_page = latch_header(false);
 
-  do {
-    if (!get_bucket_id_value(prob, key, result)) {
-      break;
-    }
-    prob = (prob + 1) % GetSize();
-  } while (prob != bucket_id);
+  // The entries that have not been moved yet are in the old block array.
+  if (!old_block_page_ids_.empty()) {
+    get_values(old_block_page_ids_, key, result);
+  }
+  get_values(block_page_ids_, key, result);
 
-  table_latch_.RUnlock();
+  unlatch_header(header_page, false);
   return !(result->empty());
 }
 /*****************************************************************************
@@ -122,26 +289,32 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  std::call_once(count_once_, [this] { count_entries(); });
 start:
-  table_latch_.RLock();
-
-  auto bucket_id = hash_fn_.GetHash(key) % GetSize();
-  auto prob = bucket_id;
-  int status;  // -1代表没有插入，1代表成功插入，0代表该kv已经存在
-  do {
-    status = insert_bucket_id_kv(prob, key, value);
-    if (status != -1) {
-      break;
+  grow();
+  auto *header_page = latch_header(false);
+
+  if (!old_block_page_ids_.empty()) {
+    std::vector<ValueType> values;
+    get_values(old_block_page_ids_, key, &values);
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+      unlatch_header(header_page, false);
+      return false;
     }
-    prob = (prob + 1) % GetSize();
-  } while (prob != bucket_id);
+  }
+  int status = insert_kv(block_page_ids_, key, value);
   if (status == -1) {
-    table_latch_.RUnlock();
-    Resize(GetSize());
+    // Only if the entries were miscounted, grow right away.
+    auto size = block_page_ids_.size() * BLOCK_ARRAY_SIZE;
+    unlatch_header(header_page, false);
+    Resize(size);
     goto start;
   }
 
-  table_latch_.RUnlock();
+  unlatch_header(header_page, false);
+  if (status == 1) {
+    num_entries_++;
+  }
   return status == 1;
 }
 
@@ -150,21 +323,21 @@ start:
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  table_latch_.RLock();
-
-  auto bucket_id = hash_fn_.GetHash(key) % GetSize();
-  auto prob = bucket_id;
-  int status;  // -1代表找不到该kv，0代表还未找到该kv，1代表找到该kv并删除
-  do {
-    status = remove_bucket_id_kv(prob, key, value);
-    if (status != 0) {
-      break;
-    }
-    prob = (prob + 1) % GetSize();
-  } while (prob != bucket_id);
+  std::call_once(count_once_, [this] { count_entries(); });
+  grow();
+  auto *header_page = latch_header(false);
 
-  table_latch_.RUnlock();
-  return status == 1;
+  bool removed = false;
+  if (!old_block_page_ids_.empty()) {
+    removed = remove_kv(old_block_page_ids_, key, value);
+  }
+  removed = removed || remove_kv(block_page_ids_, key, value);
+
+  unlatch_header(header_page, false);
+  if (removed) {
+    num_entries_--;
+  }
+  return removed;
 }
 
 /*****************************************************************************
@@ -172,48 +345,117 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Resize(size_t initial_size) {
-  table_latch_.WLock();
+  std::lock_guard<std::mutex> guard(resize_latch_);
+  // Another thread grew the table in the meantime.
+  if (GetSize() >= 2 * initial_size) {
+    return;
+  }
+  // The old block array of a previous resize has to be emptied first.
+  migrate_blocks(SIZE_MAX);
 
-  page_id_t new_hp_id;
-  auto *new_hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->NewPage(&new_hp_id)->GetData());
+  // The new block array is not visible until it is installed in the header page of the table, which keeps its page
+  // id. The page of the new header then holds the old block array.
+  std::vector<page_id_t> new_block_page_ids;
+  page_id_t new_hp_id = new_block_array(2 * initial_size, &new_block_page_ids);
+  auto *new_hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(new_hp_id)->GetData());
+  auto *header_page = latch_header(true);
+  auto *hp = reinterpret_cast<HashTableHeaderPage *>(header_page->GetData());
+  std::swap(*hp, *new_hp);
+  hp->SetPageId(header_page_id_);
+  hp->SetOldHeaderPageId(new_hp_id);
+  hp->SetNumMigratedBlocks(0);
   new_hp->SetPageId(new_hp_id);
-  new_hp->SetSize(2 * initial_size);
-  while (new_hp->NumBlocks() * BLOCK_ARRAY_SIZE < new_hp->GetSize()) {
-    page_id_t new_block_page_id;
-    auto *new_bp =
-        reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->NewPage(&new_block_page_id)->GetData());
-    new_bp->Clear();
-    new_hp->AddBlockPageId(new_block_page_id);
-    buffer_pool_manager_->UnpinPage(new_block_page_id, true);
-  }
+  // The cached block directories change under the write latch, like the header page.
+  old_block_page_ids_ = std::move(block_page_ids_);
+  block_page_ids_ = std::move(new_block_page_ids);
+  size_ = block_page_ids_.size() * BLOCK_ARRAY_SIZE;
+  unlatch_header(header_page, true);
   buffer_pool_manager_->UnpinPage(new_hp_id, true);
+}
 
-  page_id_t old_hp_id = header_page_id_;
-  header_page_id_ = new_hp_id;
-  auto *old_hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(old_hp_id)->GetData());
-  for (decltype(old_hp->NumBlocks()) i = 0; i < old_hp->NumBlocks(); i++) {
-    auto old_bp_id = old_hp->GetBlockPageId(i);
-    auto *old_bp = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(old_hp_id));
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::migrate_blocks(size_t num_blocks) {
+  auto *header_page = latch_header(true);
+  auto *hp = reinterpret_cast<HashTableHeaderPage *>(header_page->GetData());
+  page_id_t old_hp_id = hp->GetOldHeaderPageId();
+  if (old_hp_id == INVALID_PAGE_ID) {
+    unlatch_header(header_page, true);
+    return;
+  }
+  // The header page is write latched, no other operation accesses the blocks.
+  auto num_migrated = hp->GetNumMigratedBlocks();
+  for (; num_migrated < old_block_page_ids_.size() && num_blocks > 0; num_migrated++, num_blocks--) {
+    auto old_bp_id = old_block_page_ids_[num_migrated];
+    auto *old_bp =
+        reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(old_bp_id)->GetData());
     for (decltype(BLOCK_ARRAY_SIZE) j = 0; j < BLOCK_ARRAY_SIZE; j++) {
       if (old_bp->IsReadable(j)) {
-        auto key = old_bp->KeyAt(j);
-        auto value = old_bp->ValueAt(j);
-        auto bucket_id = hash_fn_.GetHash(key) % GetSize();
-        auto prob = bucket_id;
-        int status;  // -1代表没有插入，1代表成功插入，0代表该kv已经存在
-        do {
-          status = insert_bucket_id_kv(prob, key, value);
-          prob = (prob + 1) % GetSize();
-        } while (status == -1);
+        // The new block array is twice as large and grows before it is full, there is room.
+        [[maybe_unused]] int status = insert_kv(block_page_ids_, old_bp->KeyAt(j), old_bp->ValueAt(j));
+        BUSTUB_ASSERT(status != -1, "The new block array cannot be full.");
+        old_bp->Remove(j);
       }
     }
-    buffer_pool_manager_->UnpinPage(old_bp_id, false);
-    buffer_pool_manager_->DeletePage(old_bp_id);
+    buffer_pool_manager_->UnpinPage(old_bp_id, true);
   }
-  buffer_pool_manager_->UnpinPage(old_hp_id, false);
-  buffer_pool_manager_->DeletePage(old_hp_id);
 
-  table_latch_.WUnlock();
+  if (num_migrated == old_block_page_ids_.size()) {
+    hp->SetOldHeaderPageId(INVALID_PAGE_ID);
+    hp->SetNumMigratedBlocks(0);
+    for (auto old_bp_id : old_block_page_ids_) {
+      buffer_pool_manager_->DeletePage(old_bp_id);
+    }
+    for (auto dp_id = old_hp_id; dp_id != INVALID_PAGE_ID;) {
+      auto *dp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(dp_id)->GetData());
+      auto next_dp_id = dp->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(dp_id, false);
+      buffer_pool_manager_->DeletePage(dp_id);
+      dp_id = next_dp_id;
+    }
+    old_block_page_ids_.clear();
+  } else {
+    hp->SetNumMigratedBlocks(num_migrated);
+  }
+  unlatch_header(header_page, true);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::grow() {
+  auto *header_page = latch_header(false);
+  auto size = block_page_ids_.size() * BLOCK_ARRAY_SIZE;
+  bool growing = !old_block_page_ids_.empty();
+  unlatch_header(header_page, false);
+  if (growing) {
+    migrate_blocks(MIGRATE_BLOCKS_PER_OP);
+  }
+  if (num_entries_ * 100 >= size * MAX_LOAD_PERCENT) {
+    Resize(size);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::count_entries() {
+  size_t num_entries = 0;
+  auto count = [this, &num_entries](const std::vector<page_id_t> &block_page_ids, size_t first_block) {
+    for (auto i = first_block; i < block_page_ids.size(); i++) {
+      auto *page = buffer_pool_manager_->FetchPage(block_page_ids[i]);
+      page->RLatch();
+      auto *bp = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+      for (decltype(BLOCK_ARRAY_SIZE) j = 0; j < BLOCK_ARRAY_SIZE; j++) {
+        num_entries += bp->IsReadable(j) ? 1 : 0;
+      }
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+  };
+  auto *header_page = latch_header(false);
+  auto *hp = reinterpret_cast<HashTableHeaderPage *>(header_page->GetData());
+  count(block_page_ids_, 0);
+  if (!old_block_page_ids_.empty()) {
+    count(old_block_page_ids_, hp->GetNumMigratedBlocks());
+  }
+  num_entries_ = num_entries;
+  unlatch_header(header_page, false);
 }
 
 /*****************************************************************************
@@ -221,10 +463,7 @@ void HASH_TABLE_TYPE::Resize(size_t initial_size) {
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 size_t HASH_TABLE_TYPE::GetSize() {
-  auto *hp = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id_)->GetData());
-  auto size = hp->NumBlocks() * BLOCK_ARRAY_SIZE;
-  buffer_pool_manager_->UnpinPage(header_page_id_, false);
-  return size;
+  return size_;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
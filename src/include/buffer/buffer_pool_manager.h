@@ -12,19 +12,59 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
 #include <list>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/mmap_disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * The frames of the pool are split into one or more shards. Every shard has its own page table, free list, replacer and
+ * latch, and a page always lives in the shard selected by its page id, so threads working on different pages rarely
+ * contend on the same latch.
+ *
+ * Fetching a page that is cached and already pinned by someone else, and unpinning a page that stays pinned, do not
+ * take any latch: they look the page up in the latch-free page table and adjust the atomic pin count of the frame. All
+ * transitions of a pin count between zero and one (which have to update the replacer), misses and evictions go through
+ * the shard latch.
+ *
+ * The data of all frames is one arena backed by 2MB huge pages when the system provides them (explicit huge pages
+ * first, then transparent huge pages), while the Page objects only hold the frame metadata.
+ *
+ * Optionally, a background page cleaner writes dirty unpinned frames back to disk whenever the fraction of dirty
+ * frames in a shard exceeds a watermark, so that eviction rarely has to write a victim while holding the shard latch.
+ *
+ * Sequential scans can ask for pages to be read ahead of their cursor with PrefetchPages. The reads are done by a
+ * prefetch thread, and the pages are left unpinned in the pool so that the scan later hits them.
+ *
+ * Dirty victims are written back asynchronously from a copy, so that the write overlaps with reading the page that
+ * replaces them. Prefetched page ranges are read with one asynchronous request per page. With logging enabled, a dirty
+ * page is only written back once the log is persistent up to the LSN of the page.
+ *
+ * For fuzzy checkpoints, every frame remembers the next LSN of the log from the time it last matched the disk, which is
+ * a lower bound of the LSNs of its changes that are not on disk yet (its recLSN). GetDirtyPageTable collects them
+ * without writing anything.
+ *
+ * On top of an MmapDiskManager the pool is read-only and does not use its frames: FetchPage returns a view of the page
+ * in the mapping of the database file, which is pinned but never evicted. NewPage and DeletePage fail, and pages must
+ * not be unpinned dirty.
  */
 class BufferPoolManager {
  public:
@@ -36,8 +76,11 @@ class BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param num_shards the number of independent partitions the pool is split into
+   * @param replacer_policy the replacement policy used to pick victims within a shard
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    size_t num_shards = 1, ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK);
 
   /**
    * Destroys an existing BufferPoolManager.
@@ -97,6 +140,66 @@ class BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() const -> size_t { return pool_size_; }
 
+  /** @return number of shards the buffer pool is split into */
+  auto GetNumShards() const -> size_t { return shards_.size(); }
+
+  /**
+   * Start the background page cleaner. Every page_cleaner_interval, or earlier when eviction had to write a dirty
+   * victim, it flushes dirty unpinned frames of every shard whose dirty ratio is above dirty_ratio, until the ratio
+   * drops to half of it.
+   * @param dirty_ratio fraction of dirty frames per shard above which the cleaner starts writing
+   */
+  void RunPageCleaner(double dirty_ratio = 0.25);
+
+  /** Stop and join the background page cleaner. */
+  void StopPageCleaner();
+
+  /**
+   * Ask the page cleaner to also write back the dirty unpinned frames whose recLSN is smaller than lsn, whatever the
+   * dirty ratio of their shard. Used after a checkpoint, so that the next one does not have to redo from as far back.
+   * @param lsn the frames with changes before this LSN are written back
+   */
+  void CleanPagesBefore(lsn_t lsn);
+
+  /**
+   * Collect the dirty page table of a fuzzy checkpoint. Pinned frames are included even if they are clean, since their
+   * changes may not have marked them dirty yet, and so is a victim whose write back may not be done.
+   * @return the id and the recLSN of every page that may differ from its copy on disk
+   */
+  auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>>;
+
+  /** @return number of fetches (including prefetches) that missed the pool and read the page from disk */
+  auto GetNumMisses() const -> size_t {
+    size_t num_misses = 0;
+    for (const auto &shard : shards_) {
+      num_misses += shard.num_misses_;
+    }
+    return num_misses;
+  }
+
+  /** @return number of dirty victims written back by threads evicting a frame */
+  auto GetNumForegroundWrites() const -> size_t { return num_foreground_writes_; }
+
+  /** @return number of dirty frames written back by the page cleaner */
+  auto GetNumBackgroundWrites() const -> size_t { return num_background_writes_; }
+
+  /** Extracts from the data of a page the id of the page that follows it, INVALID_PAGE_ID if there is none. */
+  using next_page_id_fn = std::function<page_id_t(const char *)>;
+
+  /**
+   * Asynchronously read up to count pages of a chain into the buffer pool, starting at page_id and following
+   * next_page_id, or the range [page_id, page_id + count) if next_page_id is not set. The pages are left unpinned.
+   * Prefetching stops early at the end of the chain or if no frame can be freed. Only the most recent requests are
+   * kept, older ones are dropped if the prefetch thread falls behind.
+   * @param page_id the first page to read
+   * @param count the maximum number of pages to read
+   * @param next_page_id returns the id of the page that follows a given page in the chain
+   */
+  void PrefetchPages(page_id_t page_id, size_t count, next_page_id_fn next_page_id = nullptr);
+
+  /** @return number of pages read from disk by the prefetch thread */
+  auto GetNumPrefetchedPages() const -> size_t { return num_prefetched_pages_; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -113,7 +216,9 @@ class BufferPoolManager {
 
   /**
    * Fetch the requested page from the buffer pool.
+   * Throws an Exception if the page has to be read from disk and fails its checksum.
    * @param page_id id of page to be fetched
+   * @param has_latch true if the caller already holds the latch of the shard owning page_id
    * @return the requested page
    */
   auto FetchPageImpl(page_id_t page_id, bool has_latch = false) -> Page *;
@@ -122,6 +227,7 @@ class BufferPoolManager {
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
    * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @param has_latch true if the caller already holds the latch of the shard owning page_id
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
   auto UnpinPageImpl(page_id_t page_id, bool is_dirty, bool has_latch = false) -> bool;
@@ -129,6 +235,7 @@ class BufferPoolManager {
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @param has_latch true if the caller already holds the latch of the shard owning page_id
    * @return false if the page could not be found in the page table, true otherwise
    */
   auto FlushPageImpl(page_id_t page_id, bool has_latch = false) -> bool;
@@ -138,11 +245,12 @@ class BufferPoolManager {
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  auto NewPageImpl(page_id_t *page_id, bool has_latch = false) -> Page *;
+  auto NewPageImpl(page_id_t *page_id) -> Page *;
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
+   * @param has_latch true if the caller already holds the latch of the shard owning page_id
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
   auto DeletePageImpl(page_id_t page_id, bool has_latch = false) -> bool;
@@ -150,30 +258,143 @@ class BufferPoolManager {
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
-  void FlushAllPagesImpl(bool has_latch = false);
+  void FlushAllPagesImpl();
+
+  /**
+   * A shard owns a contiguous range of frames together with the book-keeping needed to manage them. Frame ids stored
+   * in the page table, free list and replacer are local to the shard, i.e. they index into Shard::pages_.
+   */
+  struct Shard {
+    /** First frame owned by this shard, points into BufferPoolManager::pages_. */
+    Page *pages_{nullptr};
+    /** Number of frames owned by this shard. */
+    size_t num_frames_{0};
+    /** Page table for keeping track of the pages cached in this shard, readable without holding latch_. */
+    PageTable *page_table_{nullptr};
+    /** Replacer to find unpinned frames of this shard for replacement. */
+    Replacer *replacer_{nullptr};
+    /** List of free frames of this shard. */
+    std::list<frame_id_t> free_list_;
+    /** Serializes modifications of page_table_, free_list_ and the replacer, and loading/evicting frames. */
+    std::mutex latch_;
+    /** Number of pages read from disk into this shard. Only incremented under latch_. */
+    std::atomic<size_t> num_misses_{0};
+    /** Copy of the last dirty victim, written back asynchronously. Protected by latch_. */
+    char *write_back_buffer_{nullptr};
+    std::future<void> write_back_;
+    page_id_t write_back_page_id_{INVALID_PAGE_ID};
+    lsn_t write_back_clean_lsn_{INVALID_LSN};
+  };
+
+  /** @return the shard that caches the given page */
+  auto GetShard(page_id_t page_id) -> Shard & { return shards_[static_cast<size_t>(page_id) % shards_.size()]; }
 
   /** Number of pages in the buffer pool. */
   size_t pool_size_;
-  /** Array of buffer pool pages. */
+  /** Array of buffer pool pages, i.e. the metadata of the frames. */
   Page *pages_;
+  /** The data of all frames, frame i owns [arena_ + i * PAGE_SIZE, arena_ + (i + 1) * PAGE_SIZE). */
+  char *arena_;
+  /** Size of the arena mapping in bytes, a multiple of HUGE_PAGE_SIZE. */
+  size_t arena_size_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
-  LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  Replacer *replacer_;
-  /** List of free pages. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
+  LogManager *log_manager_;
+  /** The partitions of the buffer pool, a page is cached in shards_[page_id % shards_.size()]. */
+  std::vector<Shard> shards_;
+
+  /** The background page cleaner, nullptr if it is not running. */
+  std::thread *cleaner_thread_{nullptr};
+  /** Protects the cleaner state below and is used to wake the cleaner up. */
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_cv_;
+  bool run_cleaner_{false};
+  double dirty_ratio_{0};
+  /** Frames with a recLSN smaller than this are written back regardless of the dirty ratio. */
+  std::atomic<lsn_t> clean_before_lsn_{INVALID_LSN};
+  std::atomic<size_t> num_foreground_writes_{0};
+  std::atomic<size_t> num_background_writes_{0};
+
+  /** A pending PrefetchPages request. */
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t count_;
+    next_page_id_fn next_page_id_;
+  };
+  /** Maximum number of pending prefetch requests. */
+  static constexpr size_t MAX_PREFETCH_REQUESTS = 16;
+  /** The prefetch thread, started by the first PrefetchPages call. */
+  std::thread *prefetch_thread_{nullptr};
+  /** Protects the prefetch state below. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::deque<PrefetchRequest> prefetch_requests_;
+  bool run_prefetcher_{false};
+  std::atomic<size_t> num_prefetched_pages_{0};
 
  private:
+  /** Size of the huge pages backing the frame arena. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
   /**
-   * Get a free page from free_list_ or replacer_, this func is used by NewPageImpl and FetchPageImpl
-   * @return frame_id id of the free page that we found, -1 otherwise
+   * Map a zeroed, HUGE_PAGE_SIZE aligned arena of the given size, backed by huge pages if possible.
+   * @param size size of the arena in bytes, a multiple of HUGE_PAGE_SIZE
    */
-  auto get_free_page(bool has_latch = false) -> frame_id_t;
+  static auto allocate_arena(size_t size) -> char *;
+
+  /**
+   * Get a free frame from the shard's free list or replacer, evicting the victim page if necessary. The caller must
+   * hold the shard latch. This func is used by NewPageImpl and FetchPageImpl.
+   * @return frame_id id of the free frame that we found (local to the shard), -1 otherwise
+   */
+  auto get_free_page(Shard *shard) -> frame_id_t;
+
+  /**
+   * Latch-free hit path: pin a page if it is cached and already pinned.
+   * @return the pinned page, nullptr if the caller has to take the latched path
+   */
+  auto try_pin_resident(Shard *shard, page_id_t page_id) -> Page *;
+
+  /**
+   * Latch-free unpin: drop one pin of a page if that does not bring its pin count to zero.
+   * @return true if the pin was dropped, false if the caller has to take the latched path
+   */
+  static auto try_unpin(Page *page) -> bool;
+
+  /** Drop one pin of a frame, handing it to the replacer when it becomes unpinned. The shard latch must be held. */
+  static void unpin_frame(Shard *shard, frame_id_t frame_id);
+
+  /** Write back dirty unpinned frames of a shard if its dirty ratio is above the watermark. Used by the cleaner. */
+  void clean_shard(Shard *shard);
+
+  /** Read the pages of one prefetch request into the pool. Used by the prefetch thread. */
+  void prefetch(const PrefetchRequest &request);
+
+  /** Read the range of pages of a prefetch request without a chain, keeping all reads of a shard in flight at once. */
+  void prefetch_range(page_id_t page_id, size_t count);
+
+  /**
+   * Write-ahead logging: with logging enabled, make the log persistent up to the LSN of a page before the page is
+   * written back.
+   */
+  void flush_log_for(Page *page);
+
+  /** @return the next LSN of the log, INVALID_LSN without a log manager */
+  auto next_lsn() -> lsn_t;
+
+  /** Wait for the write back of the last dirty victim of a shard. The shard latch must be held. */
+  static void wait_write_back(Shard *shard);
+
+  /**
+   * Fetch the view of a page of a mapped database file.
+   * @return the pinned view, nullptr if the page is not allocated
+   */
+  auto fetch_view(page_id_t page_id) -> Page *;
+
+  /** The disk manager if it maps the database file, nullptr otherwise. */
+  MmapDiskManager *mmap_disk_manager_{nullptr};
+  /** The views of the pages of a mapped database file, views_[i] is page i. */
+  Page *views_{nullptr};
 };
 }  // namespace bustub
@@ -12,9 +12,10 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>  // NOLINT
-#include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
@@ -23,6 +24,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The state of a frame is two bits in packed atomic bitmaps: whether it is unpinned (i.e. in the replacer) and its
+ * reference bit. Pin and Unpin never block; Pin is a single atomic AND, Unpin sets the reference bit and then the
+ * unpinned bit. Victim is serialized by a latch and moves the clock hand 64 frames at a time.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -43,21 +48,28 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Remove(frame_id_t frame_id) override;
+
   auto Size() -> size_t override;
 
  private:
-  struct clock_unit {
-    bool ref_flag = true;
-    bool pin_flag = true;
-  };
+  static constexpr size_t BITS_PER_WORD = 64;
+
+  static auto bit_of(frame_id_t frame_id) -> uint64_t {
+    return uint64_t{1} << (static_cast<size_t>(frame_id) % BITS_PER_WORD);
+  }
 
-  std::vector<struct clock_unit> clock_vector;
+  size_t num_words_;
 
-  size_t ClockReplacer_frame_counter;
+  /** Bit i of word i / 64 is set if frame i is unpinned. */
+  std::unique_ptr<std::atomic<uint64_t>[]> unpinned_;
 
-  decltype(clock_vector)::iterator clock_hand;
+  /** Bit i of word i / 64 is the reference bit of frame i. */
+  std::unique_ptr<std::atomic<uint64_t>[]> ref_;
 
-  void move_clock_hand();
+  /** The clock hand points at frame hand_word_ * 64 + hand_bit_. Protected by latch_. */
+  size_t hand_word_{0};
+  size_t hand_bit_{0};
 
   std::mutex latch_;
 };
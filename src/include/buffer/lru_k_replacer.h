@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * A frame is accessed every time it is pinned. The victim is the unpinned frame whose k-th most recent access is the
+ * oldest. Frames with fewer than k accesses have an infinite backward k-distance and are victimized first, oldest
+ * first access first. A page touched once by a sequential scan therefore never pushes out pages that are accessed
+ * repeatedly.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of most recent accesses taken into account
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+ private:
+  struct frame_info {
+    /** Timestamps of the last (at most k) accesses, oldest first. */
+    std::deque<size_t> history;
+    bool evictable = false;
+  };
+
+  using entry = std::pair<size_t, frame_id_t>;
+
+  /** @return the set an evictable frame is kept in: frames with fewer than k accesses, or with k accesses */
+  auto set_of(frame_id_t frame_id) -> std::set<entry> &;
+
+  void record_access(frame_id_t frame_id);
+
+  void make_unevictable(frame_id_t frame_id);
+
+  std::vector<frame_info> frames_;
+
+  /** Evictable frames with fewer than k accesses, ordered by their first access. */
+  std::set<entry> history_set_;
+
+  /** Evictable frames with k accesses, ordered by their k-th most recent access. */
+  std::set<entry> cache_set_;
+
+  size_t k_;
+
+  size_t current_timestamp_{0};
+
+  std::mutex latch_;
+};
+
+}  // namespace bustub
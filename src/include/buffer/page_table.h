@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps page ids to the frames that cache them. It is a fixed-capacity open-addressing hash table with linear
+ * probing whose slots are single atomic words, so Find can run without holding any latch.
+ *
+ * Insert and Remove must be serialized by the caller. A concurrent Find never returns a mapping that was not present
+ * at some point, but it may miss a mapping while the table is being modified; callers have to treat a miss as "fall
+ * back to the latched path", and re-validate a hit against the frame itself.
+ */
+class PageTable {
+ public:
+  /**
+   * Create a new PageTable.
+   * @param num_frames the maximum number of mappings the table will be required to store
+   */
+  explicit PageTable(size_t num_frames);
+
+  ~PageTable() = default;
+
+  /**
+   * Look up the frame caching a page. Safe to call concurrently with Insert/Remove.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame caching the page
+   * @return true if a mapping was found, false otherwise
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) const -> bool;
+
+  /**
+   * Add a mapping. The page must not already be in the table.
+   * @param page_id the page
+   * @param frame_id the frame caching the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Remove the mapping of a page, if any.
+   * @param page_id the page
+   */
+  void Remove(page_id_t page_id);
+
+  /** @return the number of mappings in the table */
+  auto Size() const -> size_t { return size_; }
+
+ private:
+  /** A slot that was never used, probing stops here. */
+  static constexpr uint64_t EMPTY = UINT64_MAX;
+  /** A slot whose mapping was removed, probing continues past it. */
+  static constexpr uint64_t TOMBSTONE = UINT64_MAX - 1;
+
+  static auto Pack(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static auto PageIdOf(uint64_t slot) -> page_id_t { return static_cast<page_id_t>(slot >> 32); }
+  static auto FrameIdOf(uint64_t slot) -> frame_id_t { return static_cast<frame_id_t>(slot & UINT32_MAX); }
+
+  /** @return the home slot of a page */
+  auto Home(page_id_t page_id) const -> size_t {
+    // Fibonacci hashing spreads the (mostly sequential) page ids over the whole table.
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 11400714819323198485ULL >> 32) & mask_;
+  }
+
+  /** Rebuilds the table in place to get rid of tombstones. */
+  void Rehash();
+
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  /** Capacity - 1, the capacity is a power of two. */
+  size_t mask_;
+  /** Number of live mappings, only modified by writers. */
+  size_t size_{0};
+  /** Number of tombstones, only modified by writers. */
+  size_t tombstones_{0};
+};
+
+}  // namespace bustub
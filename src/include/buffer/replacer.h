@@ -16,6 +16,9 @@
 
 namespace bustub {
 
+/** The replacement policies a BufferPoolManager can be configured with. */
+enum class ReplacerPolicy { CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,6 +46,13 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets a frame entirely, e.g. because the page it cached has been deleted. The frame is no longer victimized and
+   * any access history kept for it is dropped.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual auto Size() -> size_t = 0;
 };
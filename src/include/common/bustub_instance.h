@@ -23,23 +23,30 @@ namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * @param db_file_name the database file
+   * @param pool_size the number of frames of the buffer pool
+   * @param compress_log true to compress the log records written
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t pool_size = BUFFER_POOL_SIZE,
+                          bool compress_log = false) {
     enable_logging = false;
 
     // storage related
     disk_manager_ = new DiskManager(db_file_name);
 
     // log related
-    log_manager_ = new LogManager(disk_manager_);
+    log_manager_ = new LogManager(disk_manager_, compress_log);
 
-    buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    buffer_pool_manager_ = new BufferPoolManager(pool_size, disk_manager_, log_manager_);
 
     // txn related
     lock_manager_ = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);  // S2PL
     transaction_manager_ = new TransactionManager(lock_manager_, log_manager_);
 
     // checkpoints
-    checkpoint_manager_ = new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_);
+    checkpoint_manager_ =
+        new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_, disk_manager_);
   }
 
   ~BustubInstance() {
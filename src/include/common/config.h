@@ -16,6 +16,11 @@
 #include <chrono>  // NOLINT
 #include <cstdint>
 
+/** Page size in bytes, chosen when configuring the build with -DBUSTUB_PAGE_SIZE. */
+#ifndef BUSTUB_PAGE_SIZE
+#define BUSTUB_PAGE_SIZE 4096
+#endif
+
 namespace bustub {
 
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
@@ -27,14 +32,25 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The background page cleaner of the buffer pool looks for dirty frames every PAGE_CLEANER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds page_cleaner_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
-static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
-static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
+static constexpr int PAGE_SIZE = BUSTUB_PAGE_SIZE;                            // size of a data page in byte
+static constexpr int BUFFER_POOL_SIZE = 10;                                   // default size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
+static constexpr int LOG_SEGMENT_SIZE = 16 * 1024 * 1024;                     // size of a log segment file in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;        // lookback window of the lru-k replacer
+static constexpr int TABLE_SCAN_READ_AHEAD = 8;  // number of pages a table scan prefetches ahead of its cursor
+static constexpr int PAGE_CHECKSUM_SIZE = 4;     // bytes at the end of a page holding its checksum on disk
+
+static_assert(PAGE_SIZE >= 4096 && PAGE_SIZE <= 65536 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "page size must be a power of two between 4 KB and 64 KB");
+static_assert(LOG_BUFFER_SIZE <= LOG_SEGMENT_SIZE, "a log buffer must fit in a log segment");
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.h
+//
+// Identification: src/include/common/util/crc32c_util.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Crc32cUtil computes CRC-32C (Castagnoli) checksums. On CPUs with SSE4.2 the crc32 instruction is used on three
+ * interleaved streams, which hides its latency; the streams are combined with precomputed shift tables. Other CPUs
+ * use a table driven implementation.
+ */
+class Crc32cUtil {
+ public:
+  /**
+   * Compute the CRC-32C of a buffer, using the fastest implementation available on this CPU.
+   * @param data the bytes to checksum
+   * @param size number of bytes
+   * @param crc the CRC of the preceding bytes, to checksum a buffer in pieces
+   * @return the CRC-32C of the bytes
+   */
+  static uint32_t Crc32c(const char *data, size_t size, uint32_t crc = 0);
+
+  /** Portable implementation of Crc32c. */
+  static uint32_t Crc32cPortable(const char *data, size_t size, uint32_t crc = 0);
+
+  /** SSE4.2 implementation of Crc32c, may only be called if HasHardwareSupport() is true. */
+  static uint32_t Crc32cHardware(const char *data, size_t size, uint32_t crc = 0);
+
+  /** @return true if the CPU has the crc32 instruction */
+  static bool HasHardwareSupport();
+};
+
+}  // namespace bustub
@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_util.h
+//
+// Identification: src/include/common/util/lz4_util.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * Lz4Util compresses buffers in the LZ4 block format: a sequence of literal runs, each followed by a back reference of
+ * at least 4 bytes into the last 64 KB of output. The compressor is greedy with a single-entry hash table, which is
+ * fast and works well on the repetitive content of database pages.
+ */
+class Lz4Util {
+ public:
+  /**
+   * Compress a buffer.
+   * @param src the bytes to compress
+   * @param src_size number of bytes to compress
+   * @param[out] dst output buffer
+   * @param dst_capacity size of the output buffer
+   * @return the size of the compressed data, or 0 if it does not fit in the output buffer
+   */
+  static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+  /**
+   * Decompress a buffer, checking every length and offset against the buffers.
+   * @param src the compressed data
+   * @param src_size size of the compressed data
+   * @param[out] dst output buffer
+   * @param dst_size size of the uncompressed data
+   * @return false if the compressed data is malformed or does not decompress to exactly dst_size bytes
+   */
+  static bool Decompress(const char *src, size_t src_size, char *dst, size_t dst_size);
+};
+
+}  // namespace bustub
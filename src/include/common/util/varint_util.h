@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varint_util.h
+//
+// Identification: src/include/common/util/varint_util.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * VarintUtil encodes unsigned integers in 1 to 10 bytes, 7 bits per byte starting with the lowest ones. The high bit
+ * of a byte is set if more bytes follow, so that small values take a single byte.
+ */
+class VarintUtil {
+ public:
+  /** Largest size of an encoded value. */
+  static constexpr size_t MAX_SIZE = 10;
+
+  /** @return the number of bytes the value is encoded in */
+  static size_t Size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+      value >>= 7;
+      size++;
+    }
+    return size;
+  }
+
+  /**
+   * Encode a value.
+   * @param value the value to encode
+   * @param[out] data output buffer, with room for Size(value) bytes
+   * @return the number of bytes written
+   */
+  static size_t Encode(uint64_t value, char *data);
+
+  /**
+   * Decode a value, checking that it fits in the buffer.
+   * @param data the encoded value
+   * @param available number of bytes that can be read
+   * @param[out] value the decoded value
+   * @return the number of bytes read, 0 if the value is cut by the end of the buffer or does not fit in 64 bits
+   */
+  static size_t Decode(const char *data, size_t available, uint64_t *value);
+};
+
+}  // namespace bustub
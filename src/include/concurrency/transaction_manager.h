@@ -13,8 +13,11 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -42,7 +45,7 @@ class TransactionManager {
   Transaction *Begin(Transaction *txn = nullptr);
 
   /**
-   * Commits a transaction.
+   * Commits a transaction. With logging enabled, returns once the commit record is persistent.
    * @param txn the transaction to commit
    */
   void Commit(Transaction *txn);
@@ -59,6 +62,8 @@ class TransactionManager {
 
   /** The transaction map is a global list of all the running transactions in the system. */
   static std::unordered_map<txn_id_t, Transaction *> txn_map;
+  /** Protects txn_map, transactions begin concurrently. */
+  static std::mutex txn_map_latch;
 
   /**
    * Locates and returns the transaction with the given transaction ID.
@@ -66,12 +71,21 @@ class TransactionManager {
    * @return the transaction with the given transaction id
    */
   static Transaction *GetTransaction(txn_id_t txn_id) {
+    std::lock_guard<std::mutex> guard(txn_map_latch);
     assert(TransactionManager::txn_map.find(txn_id) != TransactionManager::txn_map.end());
     auto *res = TransactionManager::txn_map[txn_id];
     assert(res != nullptr);
     return res;
   }
 
+  /**
+   * Collect the active transaction table of a fuzzy checkpoint. Only transactions that began with logging enabled are
+   * tracked.
+   * @param[out] active_txn_table the id and the LSN of the begin record of every running transaction
+   * @return the smallest LSN of a begin record in the table, INVALID_LSN if the table is empty
+   */
+  lsn_t GetActiveTransactions(std::vector<std::pair<txn_id_t, lsn_t>> *active_txn_table);
+
   /** Prevents all transactions from performing operations, used for checkpointing. */
   void BlockAllTransactions();
 
@@ -98,10 +112,14 @@ class TransactionManager {
 
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
+
+  /** The running transactions and the LSNs of their begin records, for fuzzy checkpoints. */
+  std::unordered_map<txn_id_t, lsn_t> active_txns_;
+  std::mutex active_txns_latch_;
 };
 
 }  // namespace bustub
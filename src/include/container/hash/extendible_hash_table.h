@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table.h
+//
+// Identification: src/include/container/hash/extendible_hash_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
+#include "concurrency/transaction.h"
+#include "container/hash/hash_function.h"
+#include "container/hash/hash_table.h"
+#include "storage/page/hash_table_bucket_page.h"
+#include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+#define EXTENDIBLE_HASH_TABLE_TYPE ExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+/**
+ * Implementation of extendible hash table that is backed by a buffer pool manager. Non-unique keys are supported.
+ * Supports insert and delete.
+ *
+ * A directory page maps the low global depth bits of the hash of a key to a bucket page. A full bucket is split in
+ * two by one more bit of the hash, the directory doubles only when the split bucket is pointed to by a single entry.
+ * A bucket that becomes empty is merged with its split image if they have the same local depth, and the directory
+ * is halved while no bucket needs all of its bits. Unlike LinearProbeHashTable, the table never moves entries other
+ * than those of the bucket being split, and has no tombstones. A full bucket whose keys all have the same hash bits
+ * up to the maximum global depth, such as the values of one key, continues in a chain of overflow pages instead, which
+ * are deleted once they are empty.
+ *
+ * Lookups, inserts and removes read latch the table and latch the bucket page they access, read latches for lookups
+ * and write latches for inserts and removes. The latch of the first page of a bucket covers its overflow pages. Splits
+ * and merges write latch the table.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class ExtendibleHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
+ public:
+  /**
+   * Creates a new ExtendibleHashTable with a single bucket
+   *
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param hash_fn the hash function
+   */
+  ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                      HashFunction<KeyType> hash_fn);
+
+  /**
+   * Opens an existing ExtendibleHashTable, e.g. in a read-only snapshot of the database file
+   *
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param hash_fn the hash function
+   * @param directory_page_id the directory page of the table, see GetDirectoryPageId
+   */
+  ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                      HashFunction<KeyType> hash_fn, page_id_t directory_page_id);
+
+  /**
+   * Inserts a key-value pair into the hash table.
+   * @param transaction the current transaction
+   * @param key the key to create
+   * @param value the value to be associated with the key
+   * @return true if insert succeeded, false otherwise
+   */
+  bool Insert(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Deletes the associated value for the given key.
+   * @param transaction the current transaction
+   * @param key the key to delete
+   * @param value the value to delete
+   * @return true if remove succeeded, false otherwise
+   */
+  bool Remove(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Performs a point query on the hash table.
+   * @param transaction the current transaction
+   * @param key the key to look up
+   * @param[out] result the value(s) associated with a given key
+   * @return the value(s) associated with the given key
+   */
+  bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
+
+  /** @return the global depth of the directory */
+  uint32_t GetGlobalDepth();
+
+  /** @return the page id of the directory page of the hash table */
+  page_id_t GetDirectoryPageId() const { return directory_page_id_; }
+
+ private:
+  // member variable
+  page_id_t directory_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+
+  // Read latched by the operations on a bucket, write latched by splits and merges
+  ReaderWriterLatch table_latch_;
+
+  // Hash function
+  HashFunction<KeyType> hash_fn_;
+
+  /** Fetch the directory page, it has to be unpinned. */
+  HashTableDirectoryPage *fetch_directory();
+
+  /** @return the index of the directory entry of a key */
+  uint32_t key_to_directory_index(const KeyType &key, HashTableDirectoryPage *dir);
+
+  /**
+   * Call visit(bucket, &dirty) on the first page of a bucket and its overflow pages, in order, until it returns false.
+   * The first page of the bucket has to be latched, or the table write latched.
+   */
+  template <typename Visit>
+  void visit_chain(page_id_t bucket_page_id, Visit &&visit);
+
+  /** @return true if the pair is in a page of the bucket */
+  bool chain_contains(page_id_t bucket_page_id, const KeyType &key, const ValueType &value);
+
+  /**
+   * Insert into the first page of the bucket that has room, appending an overflow page if none has and overflow is
+   * set. @return true if the pair was inserted
+   */
+  bool chain_insert(page_id_t bucket_page_id, const KeyType &key, const ValueType &value, bool overflow);
+
+  /** Unlink and delete the empty overflow pages of a bucket. */
+  void drop_empty_overflow_pages(page_id_t bucket_page_id);
+
+  /** @return true if the bucket holds no pair and has no overflow page */
+  bool chain_is_empty(page_id_t bucket_page_id);
+
+  /**
+   * Insert into a full bucket, splitting it until the key has room, under the table write latch. A bucket whose keys
+   * all share the hash bits up to the maximum depth of the directory cannot be split and gets an overflow page instead.
+   */
+  bool split_insert(const KeyType &key, const ValueType &value);
+
+  /** Merge the bucket of a key while it is empty and has a split image of the same depth, under the write latch. */
+  void merge(const KeyType &key);
+};
+
+}  // namespace bustub
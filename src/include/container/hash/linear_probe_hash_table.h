@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
@@ -32,6 +34,21 @@ namespace bustub {
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * The table grows incrementally. Once MAX_LOAD_PERCENT of its slots are used, a block array of twice the size is
+ * allocated and becomes the one inserts go to, while the old one keeps the entries that have not been moved yet. Every
+ * insert and remove then moves the entries of the next MIGRATE_BLOCKS_PER_OP old blocks, under the write latch, and
+ * the old block array is deleted once it is empty. Lookups and removes search both block arrays. Moved entries are
+ * removed from their old slot, which stays occupied, so that the probe sequences through it are not cut.
+ *
+ * Operations read latch the header page of the table and then crab along their probe sequence, latching one block
+ * page at a time (read latches for lookups, write latches for inserts and removes), so operations on different blocks
+ * run in parallel. A step of a resize write latches the header page. The header page keeps its page id, a resize
+ * installs the new block array in it and moves the old one to a new header page.
+ *
+ * The page ids of the blocks of both block arrays are cached in memory, so that an operation fetches only the header
+ * page and the blocks it probes. The caches are read under the header page latch and replaced when a resize installs
+ * a new block array or deletes the old one, under the write latch.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -47,6 +64,17 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                 const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
 
+  /**
+   * Opens an existing LinearProbeHashTable, e.g. in a read-only snapshot of the database file
+   *
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param hash_fn the hash function
+   * @param header_page_id the header page of the table, see GetHeaderPageId
+   */
+  LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                       HashFunction<KeyType> hash_fn, page_id_t header_page_id);
+
   /**
    * Inserts a key-value pair into the hash table.
    * @param transaction the current transaction
@@ -75,7 +103,8 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Starts growing the table to at least twice the initial size provided, unless it already has that size. A
+   * previous resize is completed first. The entries are moved by the following inserts and removes.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
@@ -86,23 +115,74 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    */
   size_t GetSize();
 
+  /** @return the page id of the header page of the hash table */
+  page_id_t GetHeaderPageId() const { return header_page_id_; }
+
  private:
+  /** The table grows once this percentage of its slots hold entries. */
+  static constexpr size_t MAX_LOAD_PERCENT = 75;
+  /** Number of old blocks whose entries an insert or a remove moves while the table grows. */
+  static constexpr size_t MIGRATE_BLOCKS_PER_OP = 1;
+
   // member variable
   page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writer is only resize
-  ReaderWriterLatch table_latch_;
+  // Serializes the resizes, which allocate the new block array without latching the header page
+  std::mutex resize_latch_;
+  // Page ids of the blocks of the block array, and of the old block array while the table grows
+  std::vector<page_id_t> block_page_ids_;
+  std::vector<page_id_t> old_block_page_ids_;
+  // Number of slots of the block array, readable without latching the header page
+  std::atomic<size_t> size_{0};
+  // Number of entries in the table, counted on the first insert into a table that was opened
+  std::atomic<size_t> num_entries_{0};
+  std::once_flag count_once_;
 
   // Hash function
   HashFunction<KeyType> hash_fn_;
 
-  bool get_bucket_id_value(u_int64_t prob, const KeyType &key, std::vector<ValueType> *result);
+  /**
+   * Visit the slots of a block array along the probe sequence of a hash, until visit returns false. The slots are
+   * visited in groups of up to TAG_GROUP_SIZE consecutive slots of a block, whose tags the block page compares at once.
+   * The block pages are latched hand over hand, visit sets its last argument if it modified the block.
+   */
+  template <typename Visit>
+  void probe(const std::vector<page_id_t> &block_page_ids, uint64_t hash, bool exclusive, Visit &&visit);
+
+  /** Fetch and latch the header page of the table. */
+  Page *latch_header(bool exclusive);
+
+  /** Unlatch and unpin the header page of the table, it is dirty if it was write latched. */
+  void unlatch_header(Page *page, bool exclusive);
+
+  /** Look a key up in a block array. */
+  void get_values(const std::vector<page_id_t> &block_page_ids, const KeyType &key, std::vector<ValueType> *result);
+
+  /** Insert into a block array. @return 1 if inserted, 0 if the pair is already there, -1 if the array is full */
+  int insert_kv(const std::vector<page_id_t> &block_page_ids, const KeyType &key, const ValueType &value);
+
+  /** Remove from a block array. @return true if the pair was found and removed */
+  bool remove_kv(const std::vector<page_id_t> &block_page_ids, const KeyType &key, const ValueType &value);
+
+  /**
+   * Allocate a header page and empty blocks for at least num_buckets slots, chaining more directory pages to the
+   * header page as needed, and append the block page ids to block_page_ids. @return the header page
+   */
+  page_id_t new_block_array(size_t num_buckets, std::vector<page_id_t> *block_page_ids);
+
+  /** Read the block page ids of a header page and the pages chained to it into block_page_ids. */
+  void load_block_page_ids(HashTableHeaderPage *hp, std::vector<page_id_t> *block_page_ids);
+
+  /** Move the entries of the next old blocks, deleting the old block array once all of them are moved. */
+  void migrate_blocks(size_t num_blocks);
 
-  int insert_bucket_id_kv(u_int64_t prob, const KeyType &key, const ValueType &value);
+  /** Move entries of the old block array while the table grows, start growing if the table is loaded enough. */
+  void grow();
 
-  int remove_bucket_id_kv(u_int64_t prob, const KeyType &key, const ValueType &value);
+  /** Count the entries of an opened table. */
+  void count_entries();
 };
 
 }  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <mutex>  // NOLINT
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
@@ -19,25 +21,44 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily, or fuzzy
+ * checkpoints that do not block anything.
+ *
+ * A fuzzy checkpoint writes no page. It logs a begin checkpoint record, then an end checkpoint record with the dirty
+ * page table of the buffer pool and the active transaction table. Recovery has to read the log from the smallest of
+ * the recLSNs of the dirty pages, the begin lsns of the active transactions and the begin checkpoint record; that log
+ * offset is stored in the end checkpoint record, which the superblock of the database file points to. The segments
+ * before it are recycled. The page cleaner is then asked to write the pages dirtied before the checkpoint in the
+ * background, so that the next checkpoint can move the redo offset forward.
  */
 class CheckpointManager {
  public:
   CheckpointManager(TransactionManager *transaction_manager, LogManager *log_manager,
-                    BufferPoolManager *buffer_pool_manager)
+                    BufferPoolManager *buffer_pool_manager, DiskManager *disk_manager)
       : transaction_manager_(transaction_manager),
         log_manager_(log_manager),
-        buffer_pool_manager_(buffer_pool_manager) {}
+        buffer_pool_manager_(buffer_pool_manager),
+        disk_manager_(disk_manager) {}
 
   ~CheckpointManager() = default;
 
+  /**
+   * Block all the transactions and make the log and every dirty page persistent, then record the checkpoint. The
+   * transactions stay blocked until EndCheckpoint.
+   */
   void BeginCheckpoint();
   void EndCheckpoint();
 
+  /** Take a fuzzy checkpoint while transactions go on. Requires logging to be enabled. */
+  void FuzzyCheckpoint();
+
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  DiskManager *disk_manager_;
+  /** Serializes checkpoints. */
+  std::mutex latch_;
 };
 
 }  // namespace bustub
@@ -14,8 +14,12 @@
 
 #include <algorithm>
 #include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <utility>
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,50 +29,179 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * The log is double buffered: records are appended to one buffer while the flush thread writes the other one, so
+ * appending goes on during the write. A transaction that commits asks for a flush and waits until its commit record is
+ * persistent. The commits that arrive while a write is in progress all wait for the next one, which makes them share a
+ * single write (group commit). Once a write fails, the persistent lsn stops advancing and the threads waiting in Flush
+ * get an exception, so that no commit is reported durable after it.
+ *
+ * Appending does not take a latch. The next lsn, the buffer being appended to and the next offset in it are packed
+ * into one word, so that a single fetch_add hands out an lsn together with the space of the record, and threads
+ * serialize their records in parallel. A record that does not fit closes the buffer and is retried in the other one
+ * once the flush thread switched buffers, its lsn is left unused. The flush thread switches buffers with a compare and
+ * swap, and before writing the closed buffer waits for the reservations in it that are still being filled.
+ *
+ * The log offsets of the recently written buffers are remembered along with their first lsn, so that checkpoints can
+ * tell where recovery has to start reading for a given lsn.
+ *
+ * Each buffer is written as a frame. The records of a frame are compressed with Lz4Util if compression is enabled and
+ * makes them smaller. The checksum is the CRC-32C of the sizes and the stored bytes, recovery stops reading a segment
+ * at the first frame that is not valid.
+ *--------------------------------------------------------------------------------------
+ * | stored_size (4 bytes) | records_size (4 bytes) | checksum (4 bytes) | stored bytes |
+ *--------------------------------------------------------------------------------------
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  /** Size of the header of a frame. */
+  static constexpr size_t FRAME_HEADER_SIZE = 3 * sizeof(uint32_t);
+  /** Largest size of a frame, the records of a full buffer stored uncompressed. */
+  static constexpr size_t MAX_FRAME_SIZE = FRAME_HEADER_SIZE + LOG_BUFFER_SIZE;
+
+  /**
+   * @param disk_manager the disk manager the log is written with
+   * @param compress true to compress the records of each write
+   */
+  explicit LogManager(DiskManager *disk_manager, bool compress = false)
+      : persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+    buffers_[0] = new char[MAX_FRAME_SIZE];
+    buffers_[1] = new char[MAX_FRAME_SIZE];
+    if (compress) {
+      compressed_frames_[0] = new char[MAX_FRAME_SIZE];
+      compressed_frames_[1] = new char[MAX_FRAME_SIZE];
+    }
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    StopFlushThread();
+    delete[] buffers_[0];
+    delete[] buffers_[1];
+    delete[] compressed_frames_[0];
+    delete[] compressed_frames_[1];
+    buffers_[0] = nullptr;
+    buffers_[1] = nullptr;
+    compressed_frames_[0] = nullptr;
+    compressed_frames_[1] = nullptr;
   }
 
+  /**
+   * Read the header of a frame.
+   * @param frame at least FRAME_HEADER_SIZE bytes
+   * @return the size of the frame, 0 if the header is not valid
+   */
+  static size_t GetFrameSize(const char *frame);
+
+  /**
+   * Verify the checksum of a frame and get its records.
+   * @param frame a frame whose header is valid, GetFrameSize bytes
+   * @param buffer room for LOG_BUFFER_SIZE bytes, where compressed records are decompressed
+   * @param[out] records_size the size of the records
+   * @return the records, in the frame or in the buffer, nullptr if the frame is corrupt
+   */
+  static const char *GetFrameRecords(const char *frame, char *buffer, size_t *records_size);
+
+  /** Set enable_logging and start the flush thread. */
   void RunFlushThread();
+
+  /** Flush the log buffer, stop and join the flush thread, and clear enable_logging. */
   void StopFlushThread();
 
+  /**
+   * Append a log record to the log buffer, waiting for a flush if the buffer is full.
+   * @param log_record the record to append, its lsn is set
+   * @return the lsn assigned to the record, lsns are increasing but not necessarily consecutive
+   */
   lsn_t AppendLogRecord(LogRecord *log_record);
 
-  inline lsn_t GetNextLSN() { return next_lsn_; }
+  /**
+   * Block until the log records up to lsn are persistent, asking for a flush right away instead of waiting for the
+   * timeout. Records that have not been appended yet are not waited for.
+   * @param lsn the last lsn that has to be persistent
+   * @throws Exception if a log write failed before the records became persistent
+   */
+  void Flush(lsn_t lsn);
+
+  /**
+   * Find where to read the log from to get a persistent record. The offset is the start of the buffer the record was
+   * written with, or the start of the log if that buffer is too old to be remembered.
+   * @param lsn the lsn of a persistent record
+   * @return a log offset at or before the record, at a frame boundary
+   */
+  size_t GetLogOffset(lsn_t lsn);
+
+  inline lsn_t GetNextLSN() { return GetReservationLSN(reservation_); }
+  /** Continue the lsns after those found in the log by recovery. No record may be appended concurrently. */
+  inline void SetNextLSN(lsn_t lsn) {
+    reservation_ = static_cast<uint64_t>(lsn) << RESERVATION_LSN_SHIFT |
+                   (reservation_ & ((uint64_t{1} << RESERVATION_LSN_SHIFT) - 1));
+  }
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline char *GetLogBuffer() { return log_buffer_; }
+  inline char *GetLogBuffer() { return buffers_[GetReservationBuffer(reservation_)] + FRAME_HEADER_SIZE; }
 
  private:
-  // TODO(students): you may add your own member variables
+  /** Layout of the reservation word: the next lsn, the buffer being appended to, the next offset in it. */
+  static constexpr int RESERVATION_LSN_SHIFT = 32;
+  static constexpr uint64_t RESERVATION_BUFFER_BIT = uint64_t{1} << 31;
+  static constexpr uint64_t RESERVATION_OFFSET_MASK = RESERVATION_BUFFER_BIT - 1;
+  /** No reservation closed the buffer. */
+  static constexpr size_t BUFFER_OPEN = SIZE_MAX;
+  /** Number of written buffers whose log offset is remembered. */
+  static constexpr size_t MAX_BUFFER_OFFSETS = 4096;
+
+  static lsn_t GetReservationLSN(uint64_t reservation) {
+    return static_cast<lsn_t>(reservation >> RESERVATION_LSN_SHIFT);
+  }
+  static int GetReservationBuffer(uint64_t reservation) { return (reservation & RESERVATION_BUFFER_BIT) != 0 ? 1 : 0; }
+  static size_t GetReservationOffset(uint64_t reservation) { return reservation & RESERVATION_OFFSET_MASK; }
+
+  /**
+   * Switch buffers and write out the records of the closed buffer. The latch is released during the write.
+   * @param lock holds latch_
+   */
+  void flush_log_buffer(std::unique_lock<std::mutex> *lock);
+
+  /** Fill in the header of a frame whose stored bytes follow it. */
+  static void write_frame_header(char *frame, uint32_t stored_size, uint32_t records_size);
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** The next lsn, the buffer being appended to and the next offset in it, see RESERVATION_LSN_SHIFT. */
+  std::atomic<uint64_t> reservation_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
-  char *log_buffer_;
-  char *flush_buffer_;
-
+  /** Records are appended to one buffer while the other one is being written, after room for the frame header. */
+  char *buffers_[2];
+  /** The frames the records of each buffer are compressed into, nullptr if compression is disabled. */
+  char *compressed_frames_[2] = {nullptr, nullptr};
+  /** Number of bytes of each buffer whose records are serialized. */
+  std::atomic<size_t> filled_[2] = {{0}, {0}};
+  /** Offset of the first reservation that did not fit in each buffer, BUFFER_OPEN if there is none. */
+  std::atomic<size_t> end_[2] = {{BUFFER_OPEN}, {BUFFER_OPEN}};
+  /** Number of buffer switches so far, only increases. Changed under latch_. */
+  std::atomic<uint64_t> buffer_switches_{0};
+  /** True while a buffer is being written. Protected by latch_. */
+  bool flushing_{false};
+  /** True once a buffer could not be written, the persistent lsn does not advance anymore. Protected by latch_. */
+  bool log_failed_{false};
+  /** The first lsn and the log offset of the last written buffers, oldest first. Protected by latch_. */
+  std::deque<std::pair<lsn_t, size_t>> buffer_offsets_;
+
+  /** Serializes flushes and protects the state of the flush thread. */
   std::mutex latch_;
-
-  std::thread *flush_thread_ __attribute__((__unused__));
-
+  /** Wakes the flush thread up. */
   std::condition_variable cv_;
-
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  /**
+   * Signaled when buffers are switched and after every flush, to wake threads waiting for log space or for their
+   * records to be persistent.
+   */
+  std::condition_variable flushed_cv_;
+  /** True if a thread is waiting for a flush. Protected by latch_. */
+  bool flush_requested_{false};
+  bool run_flush_thread_{false};
+  std::thread *flush_thread_{nullptr};
+
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
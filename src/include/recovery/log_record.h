@@ -13,7 +13,10 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,31 +35,57 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** Start of a fuzzy checkpoint. */
+  BEGINCHECKPOINT,
+  /** End of a fuzzy checkpoint, with the dirty page table and the active transaction table. */
+  ENDCHECKPOINT,
+  /** Compensation log record, the operation with which recovery undid a record. */
+  CLR,
 };
 
 /**
  * For every write operation on the table page, you should write ahead a corresponding log record.
  *
- * For EACH log record, HEADER is like (5 fields in common, 20 bytes in total).
- *---------------------------------------------
- * | size | LSN | transID | prevLSN | LogType |
- *---------------------------------------------
+ * Records are compact: besides the lsn, integers are varints (see VarintUtil), and ids and lsns are stored plus one so
+ * that the invalid ones take a single byte. The lsn comes first and has a fixed size, the log manager reserves the
+ * space of a record before it knows its lsn.
+ *
+ * For EACH log record, HEADER is like (5 fields in common). size is the size of the whole record.
+ *----------------------------------------------------------------
+ * | LSN (4 bytes) | size | LogType (1 byte) | transID | prevLSN |
+ *----------------------------------------------------------------
+ * A rid is the page id followed by the slot number, a tuple is its size followed by its data.
  * For insert type log record
- *---------------------------------------------------------------
- * | HEADER | tuple_rid | tuple_size | tuple_data(char[] array) |
- *---------------------------------------------------------------
+ *------------------------------
+ * | HEADER | tuple_rid | tuple |
+ *------------------------------
  * For delete type (including markdelete, rollbackdelete, applydelete)
- *----------------------------------------------------------------
- * | HEADER | tuple_rid | tuple_size | tuple_data(char[] array) |
- *---------------------------------------------------------------
- * For update type log record
- *-----------------------------------------------------------------------------------
- * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
- *-----------------------------------------------------------------------------------
+ *------------------------------
+ * | HEADER | tuple_rid | tuple |
+ *------------------------------
+ * For update type log record, only the byte ranges that changed are logged. Each range follows the bytes that did not
+ * change since the previous one (gap), and may change size when the tuple does.
+ *----------------------------------------------------------------------------------------------------
+ * | HEADER | tuple_rid | old_size | new_size | num_ranges | (gap, old_bytes, new_bytes) * num_ranges |
+ *----------------------------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *------------------------------------
+ * For begin checkpoint type log record
+ *----------
+ * | HEADER |
+ *----------
+ * For end checkpoint type log record, prevLSN is the LSN of the begin checkpoint record. Recovery reads the log from
+ * redo_offset. The counts are stored plus one, 0 means that the table did not fit in the record and was not recorded.
+ *----------------------------------------------------------------------------------------------------------
+ * | HEADER | redo_offset | num_pages | (page_id, rec_lsn) * num_pages | num_txns | (txn_id, lsn) * num_txns |
+ *----------------------------------------------------------------------------------------------------------
+ * For compensation log records, the lsn of the next record of the transaction to undo, then the type and the fields
+ * of an insert, delete or update record, the operation that undid a record and that is redone in its place.
+ *-------------------------------------------------------------------
+ * | HEADER | undo_next_lsn | LogType (1 byte) | fields of the type |
+ *-------------------------------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -67,7 +96,9 @@ class LogRecord {
 
   // constructor for Transaction type(BEGIN/COMMIT/ABORT)
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type)
-      : size_(HEADER_SIZE), txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type) {}
+      : txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type) {
+    set_size();
+  }
 
   // constructor for INSERT/DELETE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &rid, const Tuple &tuple)
@@ -81,33 +112,52 @@ class LogRecord {
       delete_rid_ = rid;
       delete_tuple_ = tuple;
     }
-    // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
+    set_size();
   }
 
-  // constructor for UPDATE type
+  // constructor for UPDATE type, only the difference between the tuples is kept
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &update_rid,
             const Tuple &old_tuple, const Tuple &new_tuple)
-      : txn_id_(txn_id),
-        prev_lsn_(prev_lsn),
-        log_record_type_(log_record_type),
-        update_rid_(update_rid),
-        old_tuple_(old_tuple),
-        new_tuple_(new_tuple) {
-    // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + old_tuple.GetLength() + new_tuple.GetLength() + 2 * sizeof(int32_t);
+      : txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type), update_rid_(update_rid) {
+    set_update_ranges(old_tuple, new_tuple);
+    set_size();
   }
 
   // constructor for NEWPAGE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t prev_page_id, page_id_t page_id)
-      : size_(HEADER_SIZE),
-        txn_id_(txn_id),
+      : txn_id_(txn_id),
         prev_lsn_(prev_lsn),
         log_record_type_(log_record_type),
         prev_page_id_(prev_page_id),
         page_id_(page_id) {
-    // calculate log record size, header size + sizeof(prev_page_id) + sizeof(page_id)
-    size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
+    set_size();
+  }
+
+  // constructor for ENDCHECKPOINT type
+  LogRecord(lsn_t begin_lsn, size_t redo_offset, std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table,
+            std::vector<std::pair<txn_id_t, lsn_t>> active_txn_table)
+      : prev_lsn_(begin_lsn),
+        log_record_type_(LogRecordType::ENDCHECKPOINT),
+        redo_offset_(redo_offset),
+        dirty_page_table_(std::move(dirty_page_table)),
+        active_txn_table_(std::move(active_txn_table)) {
+    set_size();
+    // Tables that would not fit in a log buffer are left out.
+    if (size_ > LOG_BUFFER_SIZE) {
+      tables_recorded_ = false;
+      dirty_page_table_.clear();
+      active_txn_table_.clear();
+      set_size();
+    }
+  }
+
+  // constructor for CLR type, from the record of the operation that undid a record
+  LogRecord(const LogRecord &action, lsn_t undo_next_lsn) : LogRecord(action) {
+    assert(action.log_record_type_ >= LogRecordType::INSERT && action.log_record_type_ <= LogRecordType::UPDATE);
+    action_type_ = log_record_type_;
+    log_record_type_ = LogRecordType::CLR;
+    undo_next_lsn_ = undo_next_lsn;
+    set_size();
   }
 
   ~LogRecord() = default;
@@ -130,6 +180,39 @@ class LogRecord {
 
   inline LogRecordType &GetLogRecordType() { return log_record_type_; }
 
+  inline lsn_t GetUndoNextLSN() { return undo_next_lsn_; }
+
+  /**
+   * Serialize the record, its lsn must be set.
+   * @param[out] data output buffer, with room for GetSize() bytes
+   */
+  void SerializeTo(char *data) const;
+
+  /**
+   * Deserialize a record. The whole record, as given by its size field, must be in the buffer. Records that do not
+   * match their type are rejected, so that zeros and garbage are not taken for records.
+   * @param data the serialized record
+   * @param available number of bytes that can be read
+   * @return false if there is no valid record in the buffer
+   */
+  bool DeserializeFrom(const char *data, size_t available);
+
+  /**
+   * Compute the tuple after an UPDATE record.
+   * @param old_tuple the tuple before the update
+   * @param[out] new_tuple the tuple after the update
+   * @return false if the tuple is not the one the record was logged for
+   */
+  bool ApplyUpdate(const Tuple &old_tuple, Tuple *new_tuple) const { return patch(old_tuple, true, new_tuple); }
+
+  /**
+   * Compute the tuple before an UPDATE record.
+   * @param new_tuple the tuple after the update
+   * @param[out] old_tuple the tuple before the update
+   * @return false if the tuple is not the one the record was logged for
+   */
+  bool RevertUpdate(const Tuple &new_tuple, Tuple *old_tuple) const { return patch(new_tuple, false, old_tuple); }
+
   // For debug purpose
   inline std::string ToString() const {
     std::ostringstream os;
@@ -144,6 +227,39 @@ class LogRecord {
   }
 
  private:
+  /** Bytes of a tuple that an UPDATE record changes. */
+  struct UpdateRange {
+    /** Number of unchanged bytes between the previous range, or the start of the tuple, and this one. */
+    uint32_t gap_;
+    std::vector<char> old_data_;
+    std::vector<char> new_data_;
+  };
+
+  /** Ranges separated by fewer unchanged bytes are merged, a range costs more than logging the bytes twice. */
+  static constexpr uint32_t MIN_UPDATE_GAP = 4;
+
+  /** @return the type of the operation that redo replays, the operation of the record that a CLR logged */
+  LogRecordType redo_type() const { return log_record_type_ == LogRecordType::CLR ? action_type_ : log_record_type_; }
+
+  /** Compute the serialized size of the record from its fields. */
+  void set_size();
+
+  /** Compute the ranges of an UPDATE record from the tuples. */
+  void set_update_ranges(const Tuple &old_tuple, const Tuple &new_tuple);
+
+  /**
+   * Serialize the fields after the header.
+   * @param data output buffer, nullptr to only compute the size
+   * @return the size of the fields
+   */
+  size_t serialize_payload(char *data) const;
+
+  /** Apply the ranges of an UPDATE record to a tuple, from the old tuple to the new one if forward is set. */
+  bool patch(const Tuple &from, bool forward, Tuple *to) const;
+
+  /** Make a tuple hold a copy of data. */
+  static void set_tuple_data(Tuple *tuple, const char *data, uint32_t size);
+
   // the length of log record(for serialization, in bytes)
   int32_t size_{0};
   // must have fields
@@ -160,15 +276,25 @@ class LogRecord {
   RID insert_rid_;
   Tuple insert_tuple_;
 
-  // case3: for update opeartion
+  // case3: for update opeartion, the sizes of the tuples and the bytes that changed
   RID update_rid_;
-  Tuple old_tuple_;
-  Tuple new_tuple_;
+  uint32_t old_tuple_size_{0};
+  uint32_t new_tuple_size_{0};
+  std::vector<UpdateRange> update_ranges_;
 
   // case4: for new page opeartion
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
-  static const int HEADER_SIZE = 20;
+
+  // case5: for end checkpoint
+  size_t redo_offset_{0};
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table_;
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txn_table_;
+  bool tables_recorded_{true};
+
+  // case6: for compensation log records, the fields of the operation are those of its type
+  LogRecordType action_type_{LogRecordType::INVALID};
+  lsn_t undo_next_lsn_{INVALID_LSN};
 };  // namespace bustub
 
 }  // namespace bustub
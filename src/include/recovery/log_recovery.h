@@ -13,45 +13,162 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * Redo reads the log sequentially in large chunks, the next chunk of a segment is read in the background while the
+ * current one is deserialized. The records that modify a table page are replayed by worker threads: each worker owns
+ * the pages whose id maps to it, so that the records of a page are replayed in log order while different pages are
+ * replayed in parallel. A NEWPAGE record also links its previous page to the new page, which is done by the worker of
+ * the previous page.
+ *
+ * The log is read frame by frame (see LogManager). The frames of a segment are followed by zeros, by a frame that a
+ * crash tore, or by the stale frames of a recycled segment, whose lsns are smaller; the scan goes on with the next
+ * segment. This relies on lsns increasing across restarts: after recovery,
+ * the log manager has to continue at GetNextLSN().
+ *
+ * Redo starts at the redo offset of the last checkpoint. The records before the checkpoint are replayed only on the
+ * pages of its dirty page table, from their recLSN on. Undo needs the records of the transactions that were running,
+ * the redo offset is before their begin records.
+ *
+ * Undo logs a CLR for each record it undoes and an ABORT record for each transaction it rolls back, with the log
+ * manager, and sets the lsn of the undone pages to that of their CLR. Redo replays the CLRs like the other records, and
+ * Undo skips the records that a CLR already undid, so that recovering again after a crash does not undo them twice.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
+  /**
+   * @param disk_manager the disk manager of the log
+   * @param buffer_pool_manager the buffer pool the pages are recovered in
+   * @param log_manager the log manager Undo appends its records with, its flush thread must not be running
+   * @param num_redo_threads number of threads replaying records in Redo, at most the number of frames
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager,
+              size_t num_redo_threads = 1)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        num_redo_threads_(std::max<size_t>(1, std::min(num_redo_threads, buffer_pool_manager->GetPoolSize()))),
+        offset_(0) {
+    // A frame cut at the end of a chunk is copied before the next one.
+    log_buffers_[0] = new char[LogManager::MAX_FRAME_SIZE + READ_SIZE];
+    log_buffers_[1] = new char[LogManager::MAX_FRAME_SIZE + READ_SIZE];
+    records_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogRecovery() {
-    delete[] log_buffer_;
-    log_buffer_ = nullptr;
+    delete[] log_buffers_[0];
+    delete[] log_buffers_[1];
+    delete[] records_buffer_;
+    log_buffers_[0] = nullptr;
+    log_buffers_[1] = nullptr;
+    records_buffer_ = nullptr;
   }
 
   void Redo();
   void Undo();
-  bool DeserializeLogRecord(const char *data, LogRecord *log_record);
+  bool DeserializeLogRecord(const char *data, size_t available, LogRecord *log_record);
+
+  /** @return the lsn after the largest lsn found by Redo, or appended by Undo once it is done */
+  inline lsn_t GetNextLSN() const { return next_lsn_; }
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Size of the reads of the log, a segment is read in whole chunks. */
+  static constexpr size_t READ_SIZE = 1 << 20;
+  static_assert(READ_SIZE >= LogManager::MAX_FRAME_SIZE && LOG_SEGMENT_SIZE % READ_SIZE == 0);
+  /** Number of records handed to a worker at once. */
+  static constexpr size_t REDO_BATCH_SIZE = 64;
+  /** Number of undone pages kept pinned until the log is flushed, at most half of the buffer pool. */
+  static constexpr size_t UNDO_BATCH_SIZE = 64;
+
+  /** A record to replay on one page, the previous page of a NEWPAGE record if link_ is set. */
+  struct RedoTask {
+    LogRecord log_record_;
+    bool link_;
+  };
+
+  struct RedoWorker {
+    std::thread thread_;
+    std::mutex latch_;
+    std::condition_variable cv_;
+    std::deque<std::vector<RedoTask>> batches_;
+    bool done_{false};
+  };
+
+  /**
+   * Read the records of the frame at a log offset. The last frame read is cached, Redo clears the cache.
+   * @param offset the log offset of the frame
+   * @param[out] records_size the size of the records
+   * @param[out] frame_size the size of the frame
+   * @return the records, nullptr if there is no valid frame at the offset
+   */
+  const char *read_frame(size_t offset, size_t *records_size, size_t *frame_size);
+
+  /**
+   * Read the end checkpoint record of the last checkpoint recorded by the disk manager.
+   * @return false if there is no checkpoint, or if its record cannot be read
+   */
+  bool read_checkpoint(LogRecord *checkpoint);
+
+  /** @return the page a record modifies, INVALID_PAGE_ID if it does not modify a page */
+  static page_id_t page_of(const LogRecord &log_record);
+
+  /** Replay a record on its page, unless the page lsn shows that the page already has it. */
+  void redo(const RedoTask &task);
+
+  /**
+   * Roll back a record of a transaction that did not finish and log a CLR for it. The page is kept pinned until
+   * release_undone_pages.
+   * @param log_record the record to undo
+   * @param prev_lsn the last record logged for the transaction
+   * @return the lsn of the CLR, INVALID_LSN if the record does not need to be undone
+   */
+  lsn_t undo(const LogRecord &log_record, lsn_t prev_lsn);
+
+  /** Flush the log and unpin the undone pages, whose CLRs are then persistent. */
+  void release_undone_pages();
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  size_t num_redo_threads_;
 
-  /** Maintain active transactions and its corresponding latest lsn. */
+  /** Maintain active transactions and its corresponding latest lsn, Undo updates it with the records it logs. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
-  /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** Mapping the log sequence number to the log file offset of its frame and its offset in the records, for undos. */
+  std::unordered_map<lsn_t, std::pair<size_t, size_t>> lsn_mapping_;
+  lsn_t next_lsn_{0};
+  /** Pages that Undo changed since the log was last flushed, pinned once per change. */
+  std::vector<page_id_t> undone_pages_;
 
-  int offset_ __attribute__((__unused__));
-  char *log_buffer_;
+  /** Log offset of the next frame to read. */
+  size_t offset_;
+  /** The chunk being deserialized and the chunk being read, each preceded by room for a frame cut by a chunk end. */
+  char *log_buffers_[2];
+  /** Decompressed records of a frame. */
+  char *records_buffer_;
+  /** The frame cached by read_frame, SIZE_MAX if there is none. */
+  size_t cached_offset_{SIZE_MAX};
+  const char *cached_records_{nullptr};
+  size_t cached_records_size_{0};
+  size_t cached_frame_size_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_disk_manager.h
+//
+// Identification: src/include/storage/disk/compressed_disk_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * CompressedDiskManager stores pages compressed with Lz4Util, the buffer pool still reads and writes whole pages.
+ *
+ * The page images live in a separate image file (the database file name with the extension .lz4) and take a whole
+ * number of SECTOR_SIZE sectors. The database file keeps the superblock and the allocation bitmaps. A page is
+ * rewritten in place if its image takes as many sectors as before, and moved to free sectors otherwise.
+ *
+ * The page mapping table, from page id to sectors, is kept in memory. It does not have to be written: every image
+ * starts with a header naming its page and a version, and the table is rebuilt by scanning the image file on startup,
+ * keeping the latest version of every allocated page. The header of an image that is moved or deallocated is cleared,
+ * so that it cannot come back.
+ */
+class CompressedDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes compressed pages next to the specified database file.
+   * @param db_file the file name of the database file to write to
+   */
+  explicit CompressedDiskManager(const std::string &db_file);
+
+  ~CompressedDiskManager() override;
+
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void DeallocatePage(page_id_t page_id) override;
+
+  /** Also syncs the image file. */
+  void SyncDbFile() override;
+
+  /** Also truncates the image file after the last used sector. */
+  void ShrinkFile() override;
+
+  /** @return the number of bytes read from the image file */
+  size_t GetNumBytesRead() const { return num_bytes_read_; }
+
+  /** @return the number of bytes written to the image file */
+  size_t GetNumBytesWritten() const { return num_bytes_written_; }
+
+  /** Allocation unit of the image file. */
+  static constexpr size_t SECTOR_SIZE = 512;
+
+ private:
+  /** Header at the start of every page image. */
+  struct image_header {
+    uint32_t magic_;
+    page_id_t page_id_;
+    uint64_t version_;
+    // size of the image after the header
+    uint32_t size_;
+    uint32_t flags_;
+    // checksum of the fields above
+    uint32_t checksum_;
+  };
+
+  /** Sectors holding the image of a page, num_sectors_ is 0 if the page has no image. */
+  struct image_extent {
+    uint64_t sector_;
+    uint64_t num_sectors_;
+  };
+
+  /** Images are compressed unless compression does not save anything. */
+  static constexpr uint32_t IMAGE_COMPRESSED = 1;
+  /** A page stored without compression takes the most sectors. */
+  static constexpr size_t MAX_IMAGE_SECTORS = (sizeof(image_header) + PAGE_SIZE + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+  /** @return the number of sectors of an image, given by its header */
+  static uint64_t GetNumSectors(const image_header &header);
+
+  /** @return the checksum of a header */
+  static uint32_t GetHeaderChecksum(const image_header &header);
+
+  /** @return true if the header is intact and describes an image that fits in num_sectors sectors */
+  static bool IsValidHeader(const image_header &header, uint64_t num_sectors);
+
+  /** Build the page mapping table and the free sectors from the images in the image file. */
+  void LoadImages();
+
+  /** Find num_sectors free consecutive sectors, extending the image file if needed. The map latch must be held. */
+  uint64_t AllocateSectors(uint64_t num_sectors);
+
+  /** Mark the sectors of an image free. The map latch must be held. */
+  void FreeSectors(const image_extent &extent);
+
+  /** Clear the header of an image which is not current anymore. */
+  void ClearHeader(const image_extent &extent);
+
+  void WriteImageFile(const char *data, size_t size, size_t offset);
+
+  size_t ReadImageFile(char *data, size_t size, size_t offset);
+
+  std::string image_file_name_;
+  int image_fd_;
+  /** Protects the mapping table and the sector bitmap. */
+  std::mutex map_latch_;
+  // the page mapping table, indexed by page id
+  std::vector<image_extent> extents_;
+  // bit i is set if sector i is used by a current image
+  std::vector<uint64_t> sector_bitmap_;
+  // number of sectors in the image file
+  uint64_t num_sectors_{0};
+  // no sector before sector_hint_ is free
+  uint64_t sector_hint_{0};
+  uint64_t next_version_{1};
+  std::atomic<size_t> num_bytes_read_{0};
+  std::atomic<size_t> num_bytes_written_{0};
+};
+
+}  // namespace bustub
@@ -13,9 +13,15 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <future>  // NOLINT
+#include <mutex>   // NOLINT
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/config.h"
 
@@ -24,6 +30,31 @@ namespace bustub {
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * The raw I/O on the database file goes through ReadDbFile and WriteDbFile. The default implementation uses a
+ * std::fstream, subclasses can provide other backends (see PosixDiskManager). Subclasses can also store pages in
+ * another format by overriding the page calls (see CompressedDiskManager), or serve a read-only snapshot from a memory
+ * mapping (see MmapDiskManager).
+ *
+ * The database file starts with a superblock, followed by groups of one allocation bitmap page and the
+ * PAGES_PER_BITMAP pages it tracks. The bitmaps are kept in memory and written through on every allocation and
+ * deallocation, so that deallocated pages are reused, also after a restart. ShrinkFile gives the space of free pages
+ * back to the file system. The superblock also points to the last checkpoint in the log.
+ *
+ * Every page is written with a CRC-32C checksum in its last PAGE_CHECKSUM_SIZE bytes, which is verified when the page
+ * is read back, so that torn or corrupted writes are detected instead of being read as valid data. Callers never see
+ * the checksum: those bytes read back as zeros.
+ *
+ * Pages can also be read and written asynchronously. By default the requests are executed by a small pool of I/O
+ * threads on top of the synchronous calls; UringDiskManager submits them to io_uring instead.
+ *
+ * The log is a sequence of LOG_SEGMENT_SIZE segment files named after the log file ("test.log.0", "test.log.1", ...),
+ * addressed by a log offset that keeps growing across segments. A segment is preallocated when it is created, so that
+ * the writes into it are made durable with fdatasync and do not update the file size. Every write goes to a single
+ * segment: a write that does not fit in the rest of a segment starts the next one, and a restart starts a new segment,
+ * so a segment holds its records followed by zeros, or by stale records if it was recycled. Segments before an offset
+ * that is no longer needed, e.g. the last checkpoint, are recycled by RecycleLog: they are renamed to spare files and
+ * reused for the next segments, whose blocks are then already allocated.
  */
 class DiskManager {
  public:
@@ -33,42 +64,98 @@ class DiskManager {
    */
   explicit DiskManager(const std::string &db_file);
 
-  ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  virtual void WritePage(page_id_t page_id, const char *page_data);
 
   /**
    * Read a page from the database file.
+   * Throws an Exception if the checksum of the page does not match its content.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
 
   /**
-   * Flush the entire log buffer into disk.
+   * Asynchronously write a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data, must stay valid until the returned future is ready
+   * @return a future that becomes ready once the page has been written
+   */
+  virtual std::future<void> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /**
+   * Asynchronously read a page from the database file.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must stay valid until the returned future is ready
+   * @return a future that becomes ready once the page has been read
+   */
+  virtual std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /**
+   * Flush the entire log buffer into disk. Returns once the data is durable.
    * @param log_data raw log data
-   * @param size size of log entry
+   * @param size size of log entry, at most LOG_SEGMENT_SIZE
+   * @throws Exception if the data could not be written or synced, the log offset is not advanced and every later
+   * write fails as well
    */
   void WriteLog(char *log_data, int size);
 
   /**
-   * Read a log entry from the log file.
+   * Read a log entry from the log file. The bytes past the end of a segment, or of the data written since the disk
+   * manager was created, read as zeros.
    * @param[out] log_data output buffer
    * @param size size of the log entry
-   * @param offset offset of the log entry in the file
-   * @return true if the read was successful, false otherwise
+   * @param offset log offset of the log entry
+   * @return true if the read was successful, false if the offset is not in a segment or past the end of the log
+   */
+  bool ReadLog(char *log_data, int size, size_t offset);
+
+  /**
+   * Make all the pages written so far durable, then record the last checkpoint in the superblock.
+   * @param offset a log offset from which the end checkpoint record is found by reading the records in order
+   * @param lsn the lsn of the end checkpoint record
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  void SetCheckpoint(size_t offset, lsn_t lsn);
+
+  /**
+   * Get the last checkpoint recorded by SetCheckpoint, also before a restart.
+   * @param[out] offset the log offset of the checkpoint
+   * @param[out] lsn the lsn of the end checkpoint record
+   * @return false if there is no checkpoint
+   */
+  bool GetCheckpoint(size_t *offset, lsn_t *lsn);
+
+  /** Make the pages written to the database file durable. */
+  virtual void SyncDbFile();
+
+  /** @return the log offset of the start of the first segment that was not recycled */
+  size_t GetLogStartOffset();
+
+  /** @return the log offset after the data written last, WriteLog appends after it or at the next segment */
+  size_t GetLogOffset();
+
+  /**
+   * Recycle the log segments that end before the given offset. The segment being written is kept.
+   * @param offset the log before this offset is no longer needed
+   */
+  void RecycleLog(size_t offset);
+
+  /**
+   * Remove the log segments and spare segment files of a database.
+   * @param db_file the file name of the database file
+   */
+  static void RemoveLogFiles(const std::string &db_file);
 
   /**
    * Allocate a page on disk.
@@ -80,7 +167,13 @@ class DiskManager {
    * Deallocate a page on disk.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(page_id_t page_id);
+  virtual void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Give the space of free pages back to the file system: the file is truncated after the last allocated page, and
+   * the free pages before it are punched out of the file where the file system supports it.
+   */
+  virtual void ShrinkFile();
 
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
@@ -101,18 +194,126 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
+  /** Write the superblock of a new database file, or check the superblock and load the bitmaps of an existing one. */
+  void OpenDbFile();
+
+  /** Write the superblock, with the last checkpoint. */
+  void WriteSuperblock();
+
+  /** Write the allocation bitmap page of a group through to the file. The alloc latch must be held. */
+  void WriteBitmap(size_t group);
+
+  /** @return the offset of the allocation bitmap page of a group in the database file */
+  static size_t GetBitmapOffset(size_t group);
+
+  /** @return the name of the log file of a database file, empty if it has no extension */
+  static std::string GetLogName(const std::string &db_file);
+
+  /** Find the segments and spare segments of a log file, both sorted. */
+  static void FindLogFiles(const std::string &log_name, std::vector<size_t> *segments, std::vector<size_t> *spares);
+
+  /** @return the file name of a log segment, or of the spare file it was renamed to when it was recycled */
+  static std::string GetLogSegmentName(const std::string &log_name, size_t segment, bool spare);
+
+  /** Open the existing log segments, the log continues with a new segment. */
+  void OpenLog();
+
+  /** Create the next log segment from a spare file or a new preallocated file. The log latch must be held. */
+  void AddLogSegment();
+
+  /** Close the log segment files. */
+  void CloseLog();
+
+  /** Make the creation, renaming and removal of log files durable. */
+  void SyncLogDirectory();
+
+ protected:
+  /**
+   * Write raw bytes to the database file.
+   * @param data the bytes to write
+   * @param size number of bytes to write
+   * @param offset offset in the database file
+   * @throws Exception if the write fails
+   */
+  virtual void WriteDbFile(const char *data, size_t size, size_t offset);
+
+  /**
+   * Read raw bytes from the database file.
+   * @param[out] data output buffer
+   * @param size number of bytes to read
+   * @param offset offset in the database file
+   * @return number of bytes read, less than size if the file ends earlier
+   * @throws Exception if the read fails
+   */
+  virtual size_t ReadDbFile(char *data, size_t size, size_t offset);
+
+  /** @return the offset of a page in the database file */
+  static size_t GetPageOffset(page_id_t page_id);
+
+  /** @return true if the page is allocated */
+  bool IsAllocated(page_id_t page_id);
+
+  /** Number of pages tracked by one allocation bitmap page. */
+  static constexpr size_t WORDS_PER_BITMAP = (PAGE_SIZE - PAGE_CHECKSUM_SIZE) / sizeof(uint64_t);
+  static constexpr size_t PAGES_PER_BITMAP = WORDS_PER_BITMAP * 64;
+
+  /** Offset of the checksum in a page on disk. */
+  static constexpr size_t CHECKSUM_OFFSET = PAGE_SIZE - PAGE_CHECKSUM_SIZE;
+
+  /** Store the checksum of a page in its last PAGE_CHECKSUM_SIZE bytes. */
+  static void StampChecksum(char *page_data);
+
+  /** @return true if the checksum of a page matches its content, or if the page is all zeros (never written) */
+  static bool VerifyChecksum(const char *page_data);
+
+  /**
+   * Run a task on the I/O thread pool, which is started on first use.
+   * @param task the I/O to perform
+   * @return a future that becomes ready once the task has run
+   */
+  std::future<void> RunAsync(std::function<void()> task);
+
+  /** Wait for the queued I/O tasks and stop the I/O thread pool. */
+  void StopIOThreads();
+
   int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
   std::string log_name_;
+  // log_fds_[i] is the file of segment log_start_segment_ + i
+  std::deque<int> log_fds_;
+  size_t log_start_segment_ = 0;
+  // log offset where the next write goes, if it fits in its segment
+  size_t log_offset_ = 0;
+  // set once a log write failed, the data after log_offset_ may be lost and is never synced again
+  bool log_failed_ = false;
+  // the segments that were recycled into spare files
+  std::vector<size_t> spare_log_segments_;
+  static constexpr size_t MAX_SPARE_LOG_SEGMENTS = 4;
+  std::mutex log_latch_;
+  // the last checkpoint, see SetCheckpoint
+  size_t checkpoint_offset_ = 0;
+  lsn_t checkpoint_lsn_ = INVALID_LSN;
+  std::mutex checkpoint_latch_;
   // stream to write db file
   std::fstream db_io_;
+  // the stream has a single shared cursor, so concurrent page reads/writes must be serialized
+  std::mutex db_io_latch_;
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
+  // the allocation bitmaps of all groups, bit i is set if page i is allocated
+  std::vector<uint64_t> page_bitmap_;
+  // no word before alloc_hint_ has a free bit
+  size_t alloc_hint_;
+  std::mutex alloc_latch_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  // the I/O thread pool serving the default asynchronous requests
+  static constexpr size_t NUM_IO_THREADS = 8;
+  std::vector<std::thread> io_threads_;
+  std::deque<std::packaged_task<void()>> io_tasks_;
+  std::mutex io_tasks_latch_;
+  std::condition_variable io_tasks_cv_;
+  bool stop_io_threads_ = false;
 };
 
 }  // namespace bustub
@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_disk_manager.h
+//
+// Identification: src/include/storage/disk/mmap_disk_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * MmapDiskManager serves an existing database file read-only through a shared memory mapping, for snapshots that are
+ * never modified. A BufferPoolManager created on top of it does not copy pages into frames: FetchPage hands out views
+ * whose data points directly into the mapping, and they are never evicted.
+ *
+ * The mapping is read-only, writing to a view faults, and every write through the disk manager throws. The checksum of
+ * a page is verified the first time it is accessed. Unlike ReadPage, a view does not hide the checksum: the last
+ * PAGE_CHECKSUM_SIZE bytes of its data hold it, page layouts do not use them.
+ *
+ * The mapping is released by ShutDown, views must not be used after that.
+ */
+class MmapDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that maps the specified database file.
+   * @param db_file the file name of the database file to map
+   */
+  explicit MmapDiskManager(const std::string &db_file);
+
+  ~MmapDiskManager() override;
+
+  void ShutDown() override;
+
+  /** @return the number of page ids covered by the mapping, every allocated page has a smaller id */
+  size_t GetNumPages() const { return num_pages_; }
+
+  /**
+   * The page is not verified, see VerifyPage.
+   * @return the data of an allocated page in the mapping (all zeros if it was never written), nullptr if the page is
+   * not allocated
+   */
+  const char *GetPageData(page_id_t page_id);
+
+  /**
+   * Verify the checksum of a page, unless it already passed before.
+   * Throws an Exception if the checksum of the page does not match its content.
+   * @param page_id id of the page, GetPageData must not return nullptr for it
+   */
+  void VerifyPage(page_id_t page_id);
+
+ protected:
+  /** Throws an Exception, the database file is read-only. */
+  void WriteDbFile(const char *data, size_t size, size_t offset) override;
+
+ private:
+  int db_fd_{-1};
+  char *mapping_{nullptr};
+  size_t mapping_size_{0};
+  size_t num_pages_{0};
+  // verified_[i] is set once the checksum of page i passed
+  std::vector<std::atomic<bool>> verified_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posix_disk_manager.h
+//
+// Identification: src/include/storage/disk/posix_disk_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * PosixDiskManager accesses the database file through a raw file descriptor with pread/pwrite. Every call carries its
+ * own offset, so reads and writes of different threads are not serialized and can overlap on the device.
+ *
+ * With direct I/O the file is opened with O_DIRECT and bypasses the page cache. Buffers that are not aligned to
+ * DIRECT_IO_ALIGNMENT (frames of the buffer pool are) go through an aligned bounce buffer. If the file system does not
+ * support O_DIRECT, the file is opened without it.
+ */
+class PosixDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param direct_io true if the database file should be opened with O_DIRECT
+   */
+  explicit PosixDiskManager(const std::string &db_file, bool direct_io = false);
+
+  ~PosixDiskManager() override;
+
+  void ShutDown() override;
+
+  /** @return true if the database file is accessed with O_DIRECT */
+  bool IsDirectIO() const { return direct_io_; }
+
+  /** Alignment of buffers, offsets and sizes required by O_DIRECT. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+ protected:
+  void WriteDbFile(const char *data, size_t size, size_t offset) override;
+
+  size_t ReadDbFile(char *data, size_t size, size_t offset) override;
+
+  /** @return true if the buffer can be handed to the kernel as is */
+  bool IsAligned(const char *data, size_t size) const;
+
+  int db_fd_;
+  bool direct_io_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// uring_disk_manager.h
+//
+// Identification: src/include/storage/disk/uring_disk_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <condition_variable>  // NOLINT
+#include <future>              // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "storage/disk/posix_disk_manager.h"
+
+namespace bustub {
+
+/**
+ * UringDiskManager serves the asynchronous page reads and writes with io_uring, so that a single thread can keep many
+ * requests in flight. Requests queued by different threads while one of them is entering the kernel are submitted
+ * together in one io_uring_enter call. A reaper thread waits for completions and fulfills the futures.
+ *
+ * If the kernel does not provide io_uring (or it is not allowed), and for buffers that cannot be used with O_DIRECT,
+ * the requests fall back to the I/O thread pool of DiskManager. Synchronous calls always use pread/pwrite.
+ */
+class UringDiskManager : public PosixDiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param direct_io true if the database file should be opened with O_DIRECT
+   */
+  explicit UringDiskManager(const std::string &db_file, bool direct_io = false);
+
+  ~UringDiskManager() override;
+
+  void ShutDown() override;
+
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data) override;
+
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data) override;
+
+  /** @return true if asynchronous requests are submitted to io_uring */
+  bool IsUringEnabled() const { return ring_fd_ >= 0; }
+
+  /** Number of submission queue entries requested for the ring. */
+  static constexpr unsigned RING_ENTRIES = 64;
+
+ private:
+  /** An asynchronous request, owned by the ring from submission until its completion is reaped. */
+  struct uring_request {
+    std::promise<void> promise_;
+    struct iovec iov_;
+    page_id_t page_id_;
+    // writes own their buffer, a copy of the page with its checksum
+    bool is_read_;
+  };
+
+  /** Set up the ring, leaves ring_fd_ at -1 if io_uring cannot be used. */
+  void SetUpRing();
+
+  /** Queue a request in the submission ring and make sure it gets submitted, errors are reported by the future. */
+  std::future<void> Submit(uint8_t opcode, page_id_t page_id, char *data, bool is_read);
+
+  /** Take the entries the kernel has not consumed back out of the ring and fail their requests, holds sq_latch_. */
+  void WithdrawUnsubmitted();
+
+  /** Reaper thread: wait for completions until the stop request (a nop without request) completes. */
+  void ReapCompletions();
+
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  struct io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  struct io_uring_cqe *cqes_{nullptr};
+  unsigned entries_{0};
+
+  /** Protects the submission ring and the counters below. */
+  std::mutex sq_latch_;
+  /** Signaled when requests complete, i.e. when there is room in the ring again. */
+  std::condition_variable sq_cv_;
+  /** Requests submitted or queued but not reaped yet, at most entries_. */
+  unsigned in_flight_{0};
+  /** Requests queued in the ring but not handed to the kernel yet. */
+  unsigned unsubmitted_{0};
+  /** True while a thread is in io_uring_enter to submit the queued requests. */
+  bool submitting_{false};
+
+  std::thread reaper_thread_;
+};
+
+}  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <bitset>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -33,13 +34,32 @@ namespace bustub {
  *
  *  Here '+' means concatenation.
  *
+ * Next to the occupied and readable flags, every occupied slot has a one byte tag taken from the hash of its key. A
+ * probe compares the tags of TAG_GROUP_SIZE slots at once with SSE2 or AVX2, and only compares the keys of the slots
+ * whose tag matches. The tag of a slot that was never occupied is EMPTY_TAG, the tags of occupied slots have their high
+ * bit set, so that a zeroed page is empty.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBlockPage {
  public:
+  /** Number of slots whose tags MatchTag compares at once. */
+#if defined(__AVX2__)
+  static constexpr slot_offset_t TAG_GROUP_SIZE = 32;
+#else
+  static constexpr slot_offset_t TAG_GROUP_SIZE = 16;
+#endif
+  /** Tag of the slots that were never occupied. */
+  static constexpr uint8_t EMPTY_TAG = 0;
+
   // Delete all constructor / destructor to ensure memory safety
   HashTableBlockPage() = delete;
 
+  /**
+   * @param hash the hash of a key
+   * @return the tag of the slots holding the key
+   */
+  static uint8_t HashTag(uint64_t hash) { return static_cast<uint8_t>(hash >> 57) | 0x80; }
+
   /**
    * Gets the key at an index in the block.
    *
@@ -65,11 +85,12 @@ class HashTableBlockPage {
    * @param bucket_ind index to write the key and value to
    * @param key key to insert
    * @param value value to insert
+   * @param tag the tag of the key, see HashTag
    * @return If the value is inserted successfully, it returns true. If the
    * index is marked as occupied before the key and value can be inserted,
    * Insert returns false.
    */
-  bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value);
+  bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value, uint8_t tag);
 
   /**
    * Removes a key and value at index.
@@ -94,6 +115,15 @@ class HashTableBlockPage {
    */
   bool IsReadable(slot_offset_t bucket_ind) const;
 
+  /**
+   * Compares the tags of the TAG_GROUP_SIZE slots starting at bucket_ind, fewer at the end of the block.
+   *
+   * @param bucket_ind the first slot to compare
+   * @param tag the tag to look for, EMPTY_TAG to find the slots that were never occupied
+   * @return a mask with bit i set if the tag of slot bucket_ind + i is tag
+   */
+  uint32_t MatchTag(slot_offset_t bucket_ind, uint8_t tag) const;
+
   slot_offset_t SlotsNum() const;
 
   void Clear();
@@ -104,6 +134,9 @@ class HashTableBlockPage {
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
   std::atomic_char readable_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
 
+  // EMPTY_TAG if never occupied, HashTag of the key otherwise.
+  uint8_t tags_[BLOCK_ARRAY_SIZE];
+
   MappingType array_[BLOCK_ARRAY_SIZE];
 
   bool check_byte_bit(char a_byte, size_t bit_offset) const;
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bucket_page.h
+//
+// Identification: src/include/storage/page/hash_table_bucket_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/index/int_comparator.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+/**
+ * Store indexed key and and value together within bucket page of an extendible hash table. Supports non-unique keys,
+ * but not duplicate key/value pairs.
+ *
+ * Bucket page format (keys are stored in no particular order):
+ *  ----------------------------------------------------------------
+ * | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ... | KEY(n) + VALUE(n)
+ *  ----------------------------------------------------------------
+ *
+ *  Here '+' means concatenation.
+ *
+ * A slot holds a pair if its readable flag is set. There are no tombstones, a removed pair frees its slot. Clear()
+ * turns a page into an empty bucket.
+ *
+ * The pairs of a bucket that the directory cannot split, because all of their keys have the same hash bits, continue
+ * in a chain of overflow pages of the same format.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class HashTableBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableBucketPage() = delete;
+
+  /**
+   * Scans the bucket for the values of a key.
+   *
+   * @param key the key to look up
+   * @param cmp the comparator for keys
+   * @param[out] result the values associated with the key are appended to it
+   * @return true if at least one value was found
+   */
+  bool GetValue(const KeyType &key, KeyComparator cmp, std::vector<ValueType> *result) const;
+
+  /**
+   * Inserts a key and value into a free slot of the bucket.
+   *
+   * @param key key to insert
+   * @param value value to insert
+   * @param cmp the comparator for keys
+   * @return false if the pair is already in the bucket or the bucket is full, true otherwise
+   */
+  bool Insert(const KeyType &key, const ValueType &value, KeyComparator cmp);
+
+  /**
+   * Removes a key and value from the bucket.
+   *
+   * @param key key to remove
+   * @param value value to remove
+   * @param cmp the comparator for keys
+   * @return true if the pair was found and removed
+   */
+  bool Remove(const KeyType &key, const ValueType &value, KeyComparator cmp);
+
+  /**
+   * Gets the key at an index in the bucket.
+   *
+   * @param bucket_idx the index in the bucket to get the key at
+   * @return key at index bucket_idx of the bucket
+   */
+  KeyType KeyAt(uint32_t bucket_idx) const;
+
+  /**
+   * Gets the value at an index in the bucket.
+   *
+   * @param bucket_idx the index in the bucket to get the value at
+   * @return value at index bucket_idx of the bucket
+   */
+  ValueType ValueAt(uint32_t bucket_idx) const;
+
+  /**
+   * Frees the slot at an index.
+   *
+   * @param bucket_idx index to remove the pair from
+   */
+  void RemoveAt(uint32_t bucket_idx);
+
+  /**
+   * Returns whether or not an index holds a key/value pair
+   *
+   * @param bucket_idx index to look at
+   * @return true if the index is readable, false otherwise
+   */
+  bool IsReadable(uint32_t bucket_idx) const;
+
+  /** @return the number of key/value pairs in the bucket */
+  uint32_t NumReadable() const;
+
+  /** @return true if every slot of the bucket holds a pair */
+  bool IsFull() const;
+
+  /** @return true if no slot of the bucket holds a pair */
+  bool IsEmpty() const;
+
+  uint32_t SlotsNum() const;
+
+  /** Frees all slots and unlinks the overflow pages */
+  void Clear();
+
+  /** @return the overflow page holding more pairs of the bucket, INVALID_PAGE_ID if there is none */
+  page_id_t GetNextPageId() const;
+
+  /**
+   * Sets the overflow page holding more pairs of the bucket
+   *
+   * @param page_id the next page of the bucket
+   */
+  void SetNextPageId(page_id_t page_id);
+
+ private:
+  page_id_t next_page_id_;
+
+  // 0 if free, 1 if the slot holds a pair.
+  char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+
+  MappingType array_[BUCKET_ARRAY_SIZE];
+};
+
+}  // namespace bustub
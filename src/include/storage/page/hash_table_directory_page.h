@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_page.h
+//
+// Identification: src/include/storage/page/hash_table_directory_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ *
+ * Directory Page for extendible hash table.
+ *
+ * Directory format (size in byte):
+ * --------------------------------------------------------------------------------------------
+ * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(DIRECTORY_ARRAY_SIZE) | BucketPageIds(4 * DIRECTORY_ARRAY_SIZE)
+ * --------------------------------------------------------------------------------------------
+ *
+ * Entry i of the directory points to the bucket of the keys whose hash ends with the GlobalDepth low bits of i. A
+ * bucket with a local depth smaller than the global depth is pointed to by several entries, which share the low bits
+ * of their index up to the local depth.
+ */
+class HashTableDirectoryPage {
+ public:
+  /** @return the page ID of this page */
+  page_id_t GetPageId() const;
+
+  /**
+   * Sets the page ID of this page
+   *
+   * @param page_id the page id for the page id field to be set to
+   */
+  void SetPageId(page_id_t page_id);
+
+  /** @return the lsn of this page */
+  lsn_t GetLSN() const;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number for the lsn field to be set to
+   */
+  void SetLSN(lsn_t lsn);
+
+  /** @return the number of low bits of a hash that select the directory entry */
+  uint32_t GetGlobalDepth() const;
+
+  /** @return a mask of the GetGlobalDepth low bits */
+  uint32_t GetGlobalDepthMask() const;
+
+  /** Doubles the directory, the new upper half points to the same buckets as the lower half. */
+  void IncrGlobalDepth();
+
+  /** Halves the directory, dropping its upper half. */
+  void DecrGlobalDepth();
+
+  /** @return true if all the local depths are smaller than the global depth, so the directory can be halved */
+  bool CanShrink() const;
+
+  /** @return the number of entries of the directory, 2^GlobalDepth */
+  uint32_t Size() const;
+
+  /** @return the maximum number of entries of the directory */
+  static uint32_t MaxSize();
+
+  /**
+   * @param bucket_idx index in the directory
+   * @return the page id of the bucket the entry points to
+   */
+  page_id_t GetBucketPageId(uint32_t bucket_idx) const;
+
+  /**
+   * @param bucket_idx index in the directory
+   * @param bucket_page_id the page id of the bucket the entry points to
+   */
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  /**
+   * @param bucket_idx index in the directory
+   * @return the local depth of the bucket the entry points to
+   */
+  uint32_t GetLocalDepth(uint32_t bucket_idx) const;
+
+  /**
+   * @param bucket_idx index in the directory
+   * @param local_depth the local depth of the bucket the entry points to
+   */
+  void SetLocalDepth(uint32_t bucket_idx, uint32_t local_depth);
+
+  /**
+   * @param bucket_idx index in the directory
+   * @return a mask of the GetLocalDepth low bits
+   */
+  uint32_t GetLocalDepthMask(uint32_t bucket_idx) const;
+
+  /**
+   * @param bucket_idx index in the directory
+   * @return the index of the entry that differs from bucket_idx in the highest bit of its local depth, the bucket it
+   * points to was split from the bucket of bucket_idx, or is merged with it
+   */
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx) const;
+
+ private:
+  lsn_t lsn_ = INVALID_LSN;
+  page_id_t page_id_ = INVALID_PAGE_ID;
+  uint32_t global_depth_ = 0;
+  uint8_t local_depths_[DIRECTORY_ARRAY_SIZE] = {};
+  page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE] = {};
+};
+
+}  // namespace bustub
@@ -26,10 +26,16 @@ namespace bustub {
  *
  * Header Page for linear probing hash table.
  *
- * Header format (size in byte, 16 bytes in total):
- * -------------------------------------------------------------
- * | LSN (4) | Size (4) | PageId(4) | NextBlockIndex(4)
- * -------------------------------------------------------------
+ * Header format (size in byte, 36 bytes in total):
+ * ------------------------------------------------------------------------------------------------------------------
+ * | LSN (4) | PageId(4) | OldHeaderPageId(4) | NumMigratedBlocks (4) | Size (8) | NextBlockIndex(8) | NextPageId(4)
+ * ------------------------------------------------------------------------------------------------------------------
+ *
+ * While the table grows, the header of the larger block array points to the header of the previous one, whose
+ * blocks before NumMigratedBlocks have been moved over.
+ *
+ * The block page ids that do not fit in the header page continue in a chain of pages of the same format, of which
+ * only the block page ids and the next page id are used.
  */
 class HashTableHeaderPage {
  public:
@@ -89,12 +95,61 @@ class HashTableHeaderPage {
    */
   size_t NumBlocks();
 
+  /**
+   * @return the number of blocks a header page can hold
+   */
+  static size_t MaxNumBlocks();
+
+  /**
+   * @return the header page of the block array whose entries are being moved to this one, INVALID_PAGE_ID if the
+   * table is not growing
+   */
+  page_id_t GetOldHeaderPageId() const;
+
+  /**
+   * Sets the header page of the block array whose entries are being moved to this one
+   *
+   * @param page_id the header page of the old block array, INVALID_PAGE_ID once it has been moved
+   */
+  void SetOldHeaderPageId(page_id_t page_id);
+
+  /**
+   * @return the number of blocks of the old block array whose entries have been moved to this one
+   */
+  size_t GetNumMigratedBlocks() const;
+
+  /**
+   * Sets the number of blocks of the old block array whose entries have been moved to this one
+   *
+   * @param num_blocks the number of blocks moved
+   */
+  void SetNumMigratedBlocks(size_t num_blocks);
+
+  /**
+   * @return the page holding the next block page ids of the block array, INVALID_PAGE_ID if this is the last one
+   */
+  page_id_t GetNextPageId() const;
+
+  /**
+   * Sets the page holding the next block page ids of the block array
+   *
+   * @param page_id the next page of the block directory
+   */
+  void SetNextPageId(page_id_t page_id);
+
  private:
+  // ordered so that there is no padding before block_page_ids_
   lsn_t lsn_ = INVALID_LSN;
-  size_t size_ = 0;
   page_id_t page_id_ = INVALID_PAGE_ID;
+  page_id_t old_header_page_id_ = INVALID_PAGE_ID;
+  uint32_t num_migrated_blocks_ = 0;
+  size_t size_ = 0;
   size_t next_ind_ = 0;
-  page_id_t block_page_ids_[(PAGE_SIZE - sizeof(lsn_) - sizeof(size_) - sizeof(page_id_) - sizeof(next_ind_)) /
+  page_id_t next_page_id_ = INVALID_PAGE_ID;
+  // the size of the page is padded to a multiple of sizeof(size_t), which has to stay clear of the checksum
+  page_id_t block_page_ids_[((PAGE_SIZE - PAGE_CHECKSUM_SIZE) / sizeof(size_t) * sizeof(size_t) - sizeof(lsn_) -
+                             sizeof(page_id_) - sizeof(old_header_page_id_) - sizeof(num_migrated_blocks_) -
+                             sizeof(size_) - sizeof(next_ind_) - sizeof(next_page_id_)) /
                             sizeof(page_id_t)] = {};
 };
 
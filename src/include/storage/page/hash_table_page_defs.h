@@ -14,11 +14,25 @@
 
 #define MappingType std::pair<KeyType, ValueType>
 
-/** BLOCK_ARRAY_SIZE is the number of (key, value) pairs that can be stored in   * a block page. It is an approximate
+/** BLOCK_ARRAY_SIZE is the number of (key, value) pairs that can be stored in a block page. It is an approximate
  * calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType). For each key/value
- * pair, we need two additional bits for occupied_ and readable_. 4 * PAGE_SIZE / (4 * sizeof (MappingType) + 1) =
- * PAGE_SIZE/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required to maintain the occupied
- * and readable flags for a key value pair.*/
-#define BLOCK_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+ * pair, we need two additional bits for occupied_ and readable_ and one byte for its hash tag. 4 * PAGE_SIZE / (4 *
+ * sizeof (MappingType) + 5) = PAGE_SIZE/(sizeof (MappingType) + 1.25) because 1.25 bytes = 2 bits + 1 byte is the space
+ * required to maintain the occupied and readable flags and the tag of a key value pair. The last PAGE_CHECKSUM_SIZE
+ * bytes of the page are left for the checksum, and 8 bytes for rounding the flags up to whole bytes and aligning the
+ * pairs.*/
+#define BLOCK_ARRAY_SIZE (4 * (PAGE_SIZE - PAGE_CHECKSUM_SIZE - 8) / (4 * sizeof(MappingType) + 5))
 
 #define HASH_TABLE_BLOCK_TYPE HashTableBlockPage<KeyType, ValueType, KeyComparator>
+
+/** BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in a bucket page of an extendible hash
+ * table. For each key/value pair, we need one additional bit for readable_: 8 * PAGE_SIZE / (8 * sizeof (MappingType)
+ * + 1). As for BLOCK_ARRAY_SIZE, the checksum and 8 bytes for rounding and alignment are left out, and 4 bytes for
+ * the page id of the next overflow page. */
+#define BUCKET_ARRAY_SIZE (8 * (PAGE_SIZE - PAGE_CHECKSUM_SIZE - 12) / (8 * sizeof(MappingType) + 1))
+
+#define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+/** DIRECTORY_ARRAY_SIZE is the maximum number of entries of the directory page of an extendible hash table, which
+ * limits its global depth to 9. Each entry takes a page id and a one byte local depth. */
+#define DIRECTORY_ARRAY_SIZE 512
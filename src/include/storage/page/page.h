@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -24,14 +25,17 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data itself is not stored inline: it lives in the frame arena of the buffer pool manager, so that the Page
+ * objects form a dense metadata array and every frame is PAGE_SIZE aligned.
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. The page data is attached by the buffer pool manager. */
+  Page() = default;
 
   /** Default destructor. */
   ~Page() = default;
@@ -78,14 +82,21 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, points into the frame arena of the buffer pool. */
+  char *data_{nullptr};
+  // The book-keeping fields are atomic because the buffer pool reads and updates them on its latch-free hit path.
   /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
   /** The pin count of this page. */
-  int pin_count_ = 0;
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
+  /**
+   * The next LSN of the log when the page was last known to match its copy on disk, i.e. when it was read, created or
+   * written back. Every change that is not on disk yet has a larger or equal LSN, so it serves as the recLSN of the
+   * page in the dirty page table of a checkpoint.
+   */
+  std::atomic<lsn_t> clean_lsn_{INVALID_LSN};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -62,6 +62,11 @@ class TablePage : public Page {
   /** @return the page ID of the next table page */
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /** @return the page ID of the table page following the one whose raw data is given */
+  static page_id_t GetNextPageId(const char *page_data) {
+    return *reinterpret_cast<const page_id_t *>(page_data + OFFSET_NEXT_PAGE_ID);
+  }
+
   /** Set the page id of the previous page in the table. */
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
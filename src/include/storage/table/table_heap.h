@@ -109,6 +109,9 @@ class TableHeap {
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
  private:
+  /** Ask the buffer pool to read the table pages starting at page_id ahead of a sequential scan. */
+  void ReadAhead(page_id_t page_id);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
@@ -12,7 +12,18 @@
 
 #include "recovery/log_manager.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "common/exception.h"
+#include "common/util/crc32c_util.h"
+#include "common/util/lz4_util.h"
+
 namespace bustub {
+
 /*
  * set enable_logging = true
  * Start a separate thread to execute flush to disk operation periodically
@@ -22,33 +33,217 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  run_flush_thread_ = true;
+  flush_thread_ = new std::thread([this] {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (run_flush_thread_) {
+      cv_.wait_for(lock, log_timeout, [this] { return flush_requested_ || !run_flush_thread_; });
+      flush_log_buffer(&lock);
+    }
+  });
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    run_flush_thread_ = false;
+    flush_thread = flush_thread_;
+    flush_thread_ = nullptr;
+  }
+  // The flush thread writes what is left in the log buffer before it exits.
+  cv_.notify_one();
+  flush_thread->join();
+  delete flush_thread;
+  enable_logging = false;
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-lsn_t LogManager::AppendLogRecord(LogRecord *log_record) { return INVALID_LSN; }
+lsn_t LogManager::AppendLogRecord(LogRecord *log_record) {
+  auto size = static_cast<size_t>(log_record->size_);
+  while (true) {
+    // Read before reserving: if the buffers are switched in between, the wait below ends right away and we retry.
+    uint64_t switches = buffer_switches_;
+    uint64_t reservation = reservation_.fetch_add((uint64_t{1} << RESERVATION_LSN_SHIFT) + size);
+    int buffer = GetReservationBuffer(reservation);
+    size_t offset = GetReservationOffset(reservation);
+    if (offset + size <= LOG_BUFFER_SIZE) {
+      log_record->lsn_ = GetReservationLSN(reservation);
+      log_record->SerializeTo(buffers_[buffer] + FRAME_HEADER_SIZE + offset);
+      filled_[buffer].fetch_add(size, std::memory_order_release);
+      return log_record->lsn_;
+    }
+    // Reservations are contiguous, only the first one that does not fit starts inside the buffer.
+    if (offset <= LOG_BUFFER_SIZE) {
+      end_[buffer] = offset;
+    }
+    std::unique_lock<std::mutex> lock(latch_);
+    if (flush_thread_ == nullptr) {
+      flush_log_buffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    // The buffer may be switched back before the latch is ours, count the switches rather than compare buffers.
+    flushed_cv_.wait(lock, [&] { return buffer_switches_ != switches; });
+  }
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn = std::min(lsn, GetNextLSN() - 1);
+  while (persistent_lsn_ < lsn) {
+    if (log_failed_) {
+      throw Exception("can't flush the log up to lsn " + std::to_string(lsn) + ", a log write failed");
+    }
+    if (flush_thread_ == nullptr) {
+      flush_log_buffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
+
+size_t LogManager::GetLogOffset(lsn_t lsn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto next = std::upper_bound(buffer_offsets_.begin(), buffer_offsets_.end(), lsn,
+                               [](lsn_t value, const std::pair<lsn_t, size_t> &entry) { return value < entry.first; });
+  if (next == buffer_offsets_.begin()) {
+    return disk_manager_->GetLogStartOffset();
+  }
+  return std::prev(next)->second;
+}
+
+void LogManager::flush_log_buffer(std::unique_lock<std::mutex> *lock) {
+  // The other buffer is in use until the previous write is done.
+  flushed_cv_.wait(*lock, [this] { return !flushing_; });
+  flush_requested_ = false;
+  // Switch buffers, the lsn counter goes on.
+  uint64_t reservation = reservation_;
+  uint64_t next_reservation;
+  do {
+    if (GetReservationOffset(reservation) == 0) {
+      return;
+    }
+    next_reservation = (reservation & ~(RESERVATION_BUFFER_BIT | RESERVATION_OFFSET_MASK)) |
+                       (GetReservationBuffer(reservation) == 0 ? RESERVATION_BUFFER_BIT : 0);
+  } while (!reservation_.compare_exchange_weak(reservation, next_reservation));
+  buffer_switches_++;
+  flushing_ = true;
+  flushed_cv_.notify_all();
+  lock->unlock();
+
+  // Every lsn handed out before the switch is either in the closed buffer or was given up by a record that did not
+  // fit. Wait for the reservations that are still being filled, or that did not fit and have not closed the buffer.
+  int buffer = GetReservationBuffer(reservation);
+  size_t size = GetReservationOffset(reservation);
+  if (size > LOG_BUFFER_SIZE) {
+    while (end_[buffer] == BUFFER_OPEN) {
+      std::this_thread::yield();
+    }
+    size = end_[buffer];
+  }
+  while (filled_[buffer].load(std::memory_order_acquire) != size) {
+    std::this_thread::yield();
+  }
+  // Every record starts with its lsn.
+  char *records = buffers_[buffer] + FRAME_HEADER_SIZE;
+  lsn_t first_lsn;
+  memcpy(&first_lsn, records, sizeof(lsn_t));
+  char *frame = buffers_[buffer];
+  size_t stored_size = size;
+  if (compressed_frames_[buffer] != nullptr) {
+    size_t compressed_size =
+        Lz4Util::Compress(records, size, compressed_frames_[buffer] + FRAME_HEADER_SIZE, size - 1);
+    if (compressed_size != 0) {
+      frame = compressed_frames_[buffer];
+      stored_size = compressed_size;
+    }
+  }
+  write_frame_header(frame, stored_size, size);
+  bool written = true;
+  try {
+    disk_manager_->WriteLog(frame, static_cast<int>(FRAME_HEADER_SIZE + stored_size));
+  } catch (const Exception &) {
+    written = false;
+  }
+  filled_[buffer] = 0;
+  end_[buffer] = BUFFER_OPEN;
+
+  lock->lock();
+  if (written) {
+    // Drop the buffers in recycled segments, and the oldest one when there are too many.
+    size_t offset = disk_manager_->GetLogOffset() - FRAME_HEADER_SIZE - stored_size;
+    size_t log_start_offset = disk_manager_->GetLogStartOffset();
+    while (!buffer_offsets_.empty() &&
+           (buffer_offsets_.front().second < log_start_offset || buffer_offsets_.size() == MAX_BUFFER_OFFSETS)) {
+      buffer_offsets_.pop_front();
+    }
+    buffer_offsets_.emplace_back(first_lsn, offset);
+    persistent_lsn_ = GetReservationLSN(reservation) - 1;
+  } else {
+    // The records of the buffer are lost, no later record can become persistent.
+    log_failed_ = true;
+  }
+  flushing_ = false;
+  flushed_cv_.notify_all();
+}
+
+void LogManager::write_frame_header(char *frame, uint32_t stored_size, uint32_t records_size) {
+  memcpy(frame, &stored_size, sizeof(uint32_t));
+  memcpy(frame + 4, &records_size, sizeof(uint32_t));
+  uint32_t checksum = Crc32cUtil::Crc32c(frame, 2 * sizeof(uint32_t));
+  checksum = Crc32cUtil::Crc32c(frame + FRAME_HEADER_SIZE, stored_size, checksum);
+  memcpy(frame + 8, &checksum, sizeof(uint32_t));
+}
+
+size_t LogManager::GetFrameSize(const char *frame) {
+  uint32_t stored_size;
+  uint32_t records_size;
+  memcpy(&stored_size, frame, sizeof(uint32_t));
+  memcpy(&records_size, frame + 4, sizeof(uint32_t));
+  // Records are only stored compressed if that makes them smaller.
+  if (records_size == 0 || records_size > LOG_BUFFER_SIZE || stored_size == 0 || stored_size > records_size) {
+    return 0;
+  }
+  return FRAME_HEADER_SIZE + stored_size;
+}
+
+const char *LogManager::GetFrameRecords(const char *frame, char *buffer, size_t *records_size) {
+  uint32_t stored_size;
+  uint32_t size;
+  uint32_t checksum;
+  memcpy(&stored_size, frame, sizeof(uint32_t));
+  memcpy(&size, frame + 4, sizeof(uint32_t));
+  memcpy(&checksum, frame + 8, sizeof(uint32_t));
+  uint32_t expected = Crc32cUtil::Crc32c(frame, 2 * sizeof(uint32_t));
+  expected = Crc32cUtil::Crc32c(frame + FRAME_HEADER_SIZE, stored_size, expected);
+  if (checksum != expected) {
+    return nullptr;
+  }
+  *records_size = size;
+  if (stored_size == size) {
+    return frame + FRAME_HEADER_SIZE;
+  }
+  return Lz4Util::Decompress(frame + FRAME_HEADER_SIZE, stored_size, buffer, size) ? buffer : nullptr;
+}
 
 }  // namespace bustub
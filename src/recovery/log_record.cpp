@@ -0,0 +1,401 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_record.cpp
+//
+// Identification: src/recovery/log_record.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_record.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/util/varint_util.h"
+
+namespace bustub {
+
+namespace {
+
+/** Writes the fields of a record, or only counts their bytes if there is no output buffer. */
+class Writer {
+ public:
+  explicit Writer(char *data) : data_(data) {}
+
+  void Varint(uint64_t value) {
+    size_ += data_ != nullptr ? VarintUtil::Encode(value, data_ + size_) : VarintUtil::Size(value);
+  }
+
+  /** Ids and lsns are -1 if they are invalid. */
+  void Id(int32_t id) { Varint(static_cast<uint64_t>(static_cast<int64_t>(id) + 1)); }
+
+  void Bytes(const char *bytes, size_t size) {
+    if (data_ != nullptr) {
+      memcpy(data_ + size_, bytes, size);
+    }
+    size_ += size;
+  }
+
+  size_t Size() const { return size_; }
+
+ private:
+  char *data_;
+  size_t size_{0};
+};
+
+/** Reads the fields of a record, every read fails once one went past the end of the record. */
+class Reader {
+ public:
+  Reader(const char *data, size_t size) : data_(data), size_(size) {}
+
+  bool Varint(uint64_t *value) {
+    size_t size = ok_ ? VarintUtil::Decode(data_ + pos_, size_ - pos_, value) : 0;
+    pos_ += size;
+    ok_ = size != 0;
+    return ok_;
+  }
+
+  bool Uint32(uint32_t *value) {
+    uint64_t value64 = 0;
+    ok_ = Varint(&value64) && value64 <= UINT32_MAX;
+    *value = static_cast<uint32_t>(value64);
+    return ok_;
+  }
+
+  bool Id(int32_t *id) {
+    uint64_t value = 0;
+    ok_ = Varint(&value) && value <= static_cast<uint64_t>(INT32_MAX) + 1;
+    *id = static_cast<int32_t>(static_cast<int64_t>(value) - 1);
+    return ok_;
+  }
+
+  /** @return the next size bytes, nullptr if there are not that many left */
+  const char *Bytes(size_t size) {
+    ok_ = ok_ && size <= size_ - pos_;
+    if (!ok_) {
+      return nullptr;
+    }
+    pos_ += size;
+    return data_ + pos_ - size;
+  }
+
+  bool AtEnd() const { return ok_ && pos_ == size_; }
+
+ private:
+  const char *data_;
+  size_t size_;
+  size_t pos_{0};
+  bool ok_{true};
+};
+
+void SerializeRID(const RID &rid, Writer *writer) {
+  writer->Id(rid.GetPageId());
+  writer->Varint(rid.GetSlotNum());
+}
+
+bool DeserializeRID(Reader *reader, RID *rid) {
+  page_id_t page_id;
+  uint32_t slot_num;
+  if (!reader->Id(&page_id) || !reader->Uint32(&slot_num)) {
+    return false;
+  }
+  rid->Set(page_id, slot_num);
+  return true;
+}
+
+}  // namespace
+
+void LogRecord::set_size() {
+  Writer writer(nullptr);
+  writer.Id(txn_id_);
+  writer.Id(prev_lsn_);
+  size_t size = sizeof(lsn_t) + 1 + writer.Size() + serialize_payload(nullptr);
+  // The size field counts itself.
+  size_t total = size + VarintUtil::Size(size);
+  while (size + VarintUtil::Size(total) != total) {
+    total = size + VarintUtil::Size(total);
+  }
+  size_ = static_cast<int32_t>(total);
+}
+
+/*
+ * Tuples of the same size usually differ in a few fixed size columns, each run of changed bytes is a range. Otherwise
+ * a varchar changed size and moved the bytes after it, a single range covers everything between the common prefix
+ * and the common suffix.
+ */
+void LogRecord::set_update_ranges(const Tuple &old_tuple, const Tuple &new_tuple) {
+  const char *old_data = old_tuple.GetData();
+  const char *new_data = new_tuple.GetData();
+  old_tuple_size_ = old_tuple.GetLength();
+  new_tuple_size_ = new_tuple.GetLength();
+  update_ranges_.clear();
+  auto add_range = [&](uint32_t gap, uint32_t old_begin, uint32_t old_end, uint32_t new_begin, uint32_t new_end) {
+    update_ranges_.push_back(UpdateRange{gap, std::vector<char>(old_data + old_begin, old_data + old_end),
+                                         std::vector<char>(new_data + new_begin, new_data + new_end)});
+  };
+  if (old_tuple_size_ != new_tuple_size_) {
+    uint32_t min_size = std::min(old_tuple_size_, new_tuple_size_);
+    uint32_t prefix = 0;
+    while (prefix < min_size && old_data[prefix] == new_data[prefix]) {
+      prefix++;
+    }
+    uint32_t suffix = 0;
+    while (suffix < min_size - prefix &&
+           old_data[old_tuple_size_ - suffix - 1] == new_data[new_tuple_size_ - suffix - 1]) {
+      suffix++;
+    }
+    add_range(prefix, prefix, old_tuple_size_ - suffix, prefix, new_tuple_size_ - suffix);
+    return;
+  }
+  uint32_t end = 0;  // end of the last range
+  uint32_t pos = 0;
+  while (pos < old_tuple_size_) {
+    if (old_data[pos] == new_data[pos]) {
+      pos++;
+      continue;
+    }
+    uint32_t begin = pos;
+    // Extend the range over the changed bytes and the short gaps between them.
+    uint32_t last = pos;
+    while (pos < old_tuple_size_ && pos - last <= MIN_UPDATE_GAP) {
+      if (old_data[pos] != new_data[pos]) {
+        last = pos;
+      }
+      pos++;
+    }
+    add_range(begin - end, begin, last + 1, begin, last + 1);
+    end = last + 1;
+    pos = end;
+  }
+}
+
+size_t LogRecord::serialize_payload(char *data) const {
+  Writer writer(data);
+  if (log_record_type_ == LogRecordType::CLR) {
+    auto action_type = static_cast<char>(action_type_);
+    writer.Id(undo_next_lsn_);
+    writer.Bytes(&action_type, 1);
+  }
+  switch (redo_type()) {
+    case LogRecordType::INSERT:
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE: {
+      bool is_insert = redo_type() == LogRecordType::INSERT;
+      const Tuple &tuple = is_insert ? insert_tuple_ : delete_tuple_;
+      SerializeRID(is_insert ? insert_rid_ : delete_rid_, &writer);
+      writer.Varint(tuple.GetLength());
+      writer.Bytes(tuple.GetData(), tuple.GetLength());
+      break;
+    }
+    case LogRecordType::UPDATE:
+      SerializeRID(update_rid_, &writer);
+      writer.Varint(old_tuple_size_);
+      writer.Varint(new_tuple_size_);
+      writer.Varint(update_ranges_.size());
+      for (const auto &range : update_ranges_) {
+        writer.Varint(range.gap_);
+        writer.Varint(range.old_data_.size());
+        writer.Varint(range.new_data_.size());
+        writer.Bytes(range.old_data_.data(), range.old_data_.size());
+        writer.Bytes(range.new_data_.data(), range.new_data_.size());
+      }
+      break;
+    case LogRecordType::NEWPAGE:
+      writer.Id(prev_page_id_);
+      writer.Id(page_id_);
+      break;
+    case LogRecordType::ENDCHECKPOINT:
+      writer.Varint(redo_offset_);
+      // 0 if the tables were left out
+      writer.Varint(tables_recorded_ ? dirty_page_table_.size() + 1 : 0);
+      for (const auto &[page_id, rec_lsn] : dirty_page_table_) {
+        writer.Id(page_id);
+        writer.Id(rec_lsn);
+      }
+      writer.Varint(tables_recorded_ ? active_txn_table_.size() + 1 : 0);
+      for (const auto &[txn_id, lsn] : active_txn_table_) {
+        writer.Id(txn_id);
+        writer.Id(lsn);
+      }
+      break;
+    default:
+      break;
+  }
+  return writer.Size();
+}
+
+void LogRecord::SerializeTo(char *data) const {
+  memcpy(data, &lsn_, sizeof(lsn_t));
+  size_t pos = sizeof(lsn_t);
+  pos += VarintUtil::Encode(size_, data + pos);
+  data[pos++] = static_cast<char>(log_record_type_);
+  Writer writer(data + pos);
+  writer.Id(txn_id_);
+  writer.Id(prev_lsn_);
+  serialize_payload(data + pos + writer.Size());
+}
+
+bool LogRecord::DeserializeFrom(const char *data, size_t available) {
+  uint64_t size;
+  if (available < sizeof(lsn_t) + 1) {
+    return false;
+  }
+  size_t size_bytes = VarintUtil::Decode(data + sizeof(lsn_t), available - sizeof(lsn_t), &size);
+  if (size_bytes == 0 || size > available || size > LOG_BUFFER_SIZE || size < sizeof(lsn_t) + size_bytes + 1) {
+    return false;
+  }
+  memcpy(&lsn_, data, sizeof(lsn_t));
+  size_ = static_cast<int32_t>(size);
+  size_t pos = sizeof(lsn_t) + size_bytes;
+  log_record_type_ = static_cast<LogRecordType>(static_cast<uint8_t>(data[pos++]));
+  Reader reader(data + pos, size - pos);
+  if (!reader.Id(&txn_id_) || !reader.Id(&prev_lsn_)) {
+    return false;
+  }
+  if (log_record_type_ == LogRecordType::CLR) {
+    const char *action_type;
+    if (!reader.Id(&undo_next_lsn_) || (action_type = reader.Bytes(1)) == nullptr) {
+      return false;
+    }
+    action_type_ = static_cast<LogRecordType>(static_cast<uint8_t>(*action_type));
+    if (action_type_ < LogRecordType::INSERT || action_type_ > LogRecordType::UPDATE) {
+      return false;
+    }
+  }
+  switch (redo_type()) {
+    case LogRecordType::BEGIN:
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+    case LogRecordType::BEGINCHECKPOINT:
+      break;
+    case LogRecordType::INSERT:
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE: {
+      bool is_insert = redo_type() == LogRecordType::INSERT;
+      uint32_t length;
+      const char *tuple_data;
+      if (!DeserializeRID(&reader, is_insert ? &insert_rid_ : &delete_rid_) || !reader.Uint32(&length) ||
+          (tuple_data = reader.Bytes(length)) == nullptr) {
+        return false;
+      }
+      set_tuple_data(is_insert ? &insert_tuple_ : &delete_tuple_, tuple_data, length);
+      break;
+    }
+    case LogRecordType::UPDATE: {
+      uint64_t num_ranges;
+      if (!DeserializeRID(&reader, &update_rid_) || !reader.Uint32(&old_tuple_size_) ||
+          !reader.Uint32(&new_tuple_size_) || !reader.Varint(&num_ranges) || num_ranges > size) {
+        return false;
+      }
+      // The ranges must fit in the old tuple, and turn it into a tuple of the new size.
+      uint64_t old_end = 0;
+      uint64_t new_end = 0;
+      update_ranges_.resize(num_ranges);
+      for (auto &range : update_ranges_) {
+        uint32_t old_length;
+        uint32_t new_length;
+        const char *old_data;
+        const char *new_data;
+        if (!reader.Uint32(&range.gap_) || !reader.Uint32(&old_length) || !reader.Uint32(&new_length) ||
+            (old_data = reader.Bytes(old_length)) == nullptr || (new_data = reader.Bytes(new_length)) == nullptr) {
+          return false;
+        }
+        range.old_data_.assign(old_data, old_data + old_length);
+        range.new_data_.assign(new_data, new_data + new_length);
+        old_end += uint64_t{range.gap_} + old_length;
+        new_end += uint64_t{range.gap_} + new_length;
+        if (old_end > old_tuple_size_ || new_end > new_tuple_size_) {
+          return false;
+        }
+      }
+      if (old_tuple_size_ - old_end != new_tuple_size_ - new_end) {
+        return false;
+      }
+      break;
+    }
+    case LogRecordType::NEWPAGE:
+      if (!reader.Id(&prev_page_id_) || !reader.Id(&page_id_)) {
+        return false;
+      }
+      break;
+    case LogRecordType::ENDCHECKPOINT: {
+      uint64_t num_pages;
+      uint64_t num_txns;
+      if (!reader.Varint(&redo_offset_) || !reader.Varint(&num_pages) || num_pages > size) {
+        return false;
+      }
+      dirty_page_table_.resize(num_pages == 0 ? 0 : num_pages - 1);
+      for (auto &[page_id, rec_lsn] : dirty_page_table_) {
+        if (!reader.Id(&page_id) || !reader.Id(&rec_lsn)) {
+          return false;
+        }
+      }
+      if (!reader.Varint(&num_txns) || num_txns > size || (num_pages == 0) != (num_txns == 0)) {
+        return false;
+      }
+      active_txn_table_.resize(num_txns == 0 ? 0 : num_txns - 1);
+      for (auto &[txn_id, lsn] : active_txn_table_) {
+        if (!reader.Id(&txn_id) || !reader.Id(&lsn)) {
+          return false;
+        }
+      }
+      tables_recorded_ = num_pages != 0;
+      break;
+    }
+    default:
+      return false;
+  }
+  return reader.AtEnd();
+}
+
+bool LogRecord::patch(const Tuple &from, bool forward, Tuple *to) const {
+  if (from.GetLength() != (forward ? old_tuple_size_ : new_tuple_size_)) {
+    return false;
+  }
+  uint32_t to_size = forward ? new_tuple_size_ : old_tuple_size_;
+  char *to_data = new char[to_size];
+  const char *from_data = from.GetData();
+  uint32_t from_pos = 0;
+  uint32_t to_pos = 0;
+  for (const auto &range : update_ranges_) {
+    const auto &from_range = forward ? range.old_data_ : range.new_data_;
+    const auto &to_range = forward ? range.new_data_ : range.old_data_;
+    memcpy(to_data + to_pos, from_data + from_pos, range.gap_);
+    from_pos += range.gap_;
+    to_pos += range.gap_;
+    // The bytes being replaced must be the logged ones.
+    if (memcmp(from_data + from_pos, from_range.data(), from_range.size()) != 0) {
+      delete[] to_data;
+      return false;
+    }
+    memcpy(to_data + to_pos, to_range.data(), to_range.size());
+    from_pos += from_range.size();
+    to_pos += to_range.size();
+  }
+  memcpy(to_data + to_pos, from_data + from_pos, to_size - to_pos);
+  if (to->allocated_) {
+    delete[] to->data_;
+  }
+  to->data_ = to_data;
+  to->size_ = to_size;
+  to->allocated_ = true;
+  return true;
+}
+
+void LogRecord::set_tuple_data(Tuple *tuple, const char *data, uint32_t size) {
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  tuple->data_ = new char[size];
+  memcpy(tuple->data_, data, size);
+  tuple->size_ = size;
+  tuple->allocated_ = true;
+}
+
+}  // namespace bustub
@@ -12,6 +12,12 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstring>
+#include <future>  // NOLINT
+#include <queue>
+#include <utility>
+
+#include "common/exception.h"
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -19,8 +25,77 @@ namespace bustub {
  * deserialize a log record from log buffer
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
+ * See LogRecord::DeserializeFrom.
  */
-bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) { return false; }
+bool LogRecovery::DeserializeLogRecord(const char *data, size_t available, LogRecord *log_record) {
+  return log_record->DeserializeFrom(data, available);
+}
+
+page_id_t LogRecovery::page_of(const LogRecord &log_record) {
+  switch (log_record.redo_type()) {
+    case LogRecordType::INSERT:
+      return log_record.insert_rid_.GetPageId();
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      return log_record.delete_rid_.GetPageId();
+    case LogRecordType::UPDATE:
+      return log_record.update_rid_.GetPageId();
+    case LogRecordType::NEWPAGE:
+      return log_record.page_id_;
+    default:
+      return INVALID_PAGE_ID;
+  }
+}
+
+const char *LogRecovery::read_frame(size_t offset, size_t *records_size, size_t *frame_size) {
+  if (offset != cached_offset_) {
+    char *frame = log_buffers_[0];
+    size_t size = 0;
+    if (disk_manager_->ReadLog(frame, LogManager::FRAME_HEADER_SIZE, offset)) {
+      size = LogManager::GetFrameSize(frame);
+    }
+    if (size == 0 || !disk_manager_->ReadLog(frame, size, offset) ||
+        (cached_records_ = LogManager::GetFrameRecords(frame, records_buffer_, &cached_records_size_)) == nullptr) {
+      cached_offset_ = SIZE_MAX;
+      return nullptr;
+    }
+    cached_offset_ = offset;
+    cached_frame_size_ = size;
+  }
+  *records_size = cached_records_size_;
+  *frame_size = cached_frame_size_;
+  return cached_records_;
+}
+
+bool LogRecovery::read_checkpoint(LogRecord *checkpoint) {
+  size_t offset;
+  lsn_t lsn;
+  if (!disk_manager_->GetCheckpoint(&offset, &lsn) || offset < disk_manager_->GetLogStartOffset()) {
+    return false;
+  }
+  // The offset is the frame of the end checkpoint record, or a frame before it in the same segment.
+  while (true) {
+    size_t records_size;
+    size_t frame_size;
+    const char *records = read_frame(offset, &records_size, &frame_size);
+    if (records == nullptr) {
+      return false;
+    }
+    for (size_t pos = 0; pos < records_size;) {
+      LogRecord log_record;
+      if (!log_record.DeserializeFrom(records + pos, records_size - pos) || log_record.lsn_ > lsn) {
+        return false;
+      }
+      if (log_record.lsn_ == lsn) {
+        *checkpoint = std::move(log_record);
+        return checkpoint->log_record_type_ == LogRecordType::ENDCHECKPOINT;
+      }
+      pos += log_record.size_;
+    }
+    offset += frame_size;
+  }
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
@@ -28,13 +103,356 @@ bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record)
  *log buffer to reduce unnecessary I/O operations), remember to compare page's
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
+ * The scan starts at the redo offset of the last checkpoint, the pages that were not in its dirty page table were on
+ * disk at the checkpoint.
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  active_txn_.clear();
+  lsn_mapping_.clear();
+
+  offset_ = disk_manager_->GetLogStartOffset();
+  lsn_t checkpoint_begin_lsn = INVALID_LSN;
+  std::unordered_map<page_id_t, lsn_t> dirty_pages;
+  LogRecord checkpoint;
+  if (read_checkpoint(&checkpoint)) {
+    offset_ = std::max(offset_, checkpoint.redo_offset_);
+    if (checkpoint.tables_recorded_) {
+      checkpoint_begin_lsn = checkpoint.prev_lsn_;
+      for (const auto &[page_id, rec_lsn] : checkpoint.dirty_page_table_) {
+        auto entry = dirty_pages.emplace(page_id, rec_lsn).first;
+        entry->second = std::min(entry->second, rec_lsn);
+      }
+    }
+  }
+
+  // With a single thread, records are replayed as they are read.
+  std::vector<std::unique_ptr<RedoWorker>> workers;
+  std::vector<std::vector<RedoTask>> pending;
+  if (num_redo_threads_ > 1) {
+    pending.resize(num_redo_threads_);
+    for (size_t i = 0; i < num_redo_threads_; i++) {
+      workers.emplace_back(new RedoWorker());
+      RedoWorker *worker = workers.back().get();
+      worker->thread_ = std::thread([this, worker] {
+        std::unique_lock<std::mutex> lock(worker->latch_);
+        while (true) {
+          worker->cv_.wait(lock, [worker] { return worker->done_ || !worker->batches_.empty(); });
+          if (worker->batches_.empty()) {
+            return;
+          }
+          auto batch = std::move(worker->batches_.front());
+          worker->batches_.pop_front();
+          lock.unlock();
+          for (const auto &task : batch) {
+            redo(task);
+          }
+          lock.lock();
+        }
+      });
+    }
+  }
+  auto hand_off = [&workers, &pending](size_t i) {
+    {
+      std::lock_guard<std::mutex> guard(workers[i]->latch_);
+      workers[i]->batches_.push_back(std::move(pending[i]));
+    }
+    workers[i]->cv_.notify_one();
+    pending[i].clear();
+  };
+  auto dispatch = [&](page_id_t page_id, const LogRecord &log_record, bool link) {
+    if (log_record.lsn_ < checkpoint_begin_lsn) {
+      auto entry = dirty_pages.find(page_id);
+      if (entry == dirty_pages.end() || log_record.lsn_ < entry->second) {
+        return;
+      }
+    }
+    if (workers.empty()) {
+      redo(RedoTask{log_record, link});
+      return;
+    }
+    size_t i = static_cast<size_t>(page_id) % num_redo_threads_;
+    pending[i].push_back(RedoTask{log_record, link});
+    if (pending[i].size() == REDO_BATCH_SIZE) {
+      hand_off(i);
+    }
+  };
+
+  // The chunks overwrite the frame cached by read_frame.
+  cached_offset_ = SIZE_MAX;
+  auto read_chunk = [this](int buffer, size_t offset) {
+    return std::async(std::launch::async, [this, buffer, offset] {
+      return disk_manager_->ReadLog(log_buffers_[buffer] + LogManager::MAX_FRAME_SIZE, READ_SIZE, offset);
+    });
+  };
+  size_t chunk = offset_ - offset_ % READ_SIZE;
+  int buffer = 0;
+  auto chunk_read = read_chunk(buffer, chunk);
+  lsn_t last_lsn = INVALID_LSN;
+  while (chunk_read.get()) {
+    size_t next_chunk = chunk + READ_SIZE;
+    bool segment_ends = next_chunk % LOG_SEGMENT_SIZE == 0;
+    std::future<bool> next_chunk_read;
+    if (!segment_ends) {
+      next_chunk_read = read_chunk(1 - buffer, next_chunk);
+    }
+    // offset_ is before the chunk if a frame was cut at the end of the previous one.
+    char *chunk_data = log_buffers_[buffer] + LogManager::MAX_FRAME_SIZE;
+    const char *pos = offset_ >= chunk ? chunk_data + (offset_ - chunk) : chunk_data - (chunk - offset_);
+    const char *end = chunk_data + READ_SIZE;
+    bool frames_end = false;
+    while (!frames_end && static_cast<size_t>(end - pos) >= LogManager::FRAME_HEADER_SIZE) {
+      size_t frame_size = LogManager::GetFrameSize(pos);
+      if (frame_size != 0 && static_cast<size_t>(end - pos) < frame_size) {
+        break;
+      }
+      size_t records_size;
+      const char *records =
+          frame_size == 0 ? nullptr : LogManager::GetFrameRecords(pos, records_buffer_, &records_size);
+      if (records == nullptr) {
+        frames_end = true;
+        break;
+      }
+      for (size_t record_pos = 0; record_pos < records_size;) {
+        LogRecord log_record;
+        if (!DeserializeLogRecord(records + record_pos, records_size - record_pos, &log_record) ||
+            log_record.lsn_ <= last_lsn) {
+          frames_end = true;
+          break;
+        }
+        last_lsn = log_record.lsn_;
+        next_lsn_ = std::max(next_lsn_, last_lsn + 1);
+        lsn_mapping_[last_lsn] = {offset_, record_pos};
+        switch (log_record.log_record_type_) {
+          case LogRecordType::COMMIT:
+          case LogRecordType::ABORT:
+            active_txn_.erase(log_record.txn_id_);
+            break;
+          case LogRecordType::BEGINCHECKPOINT:
+          case LogRecordType::ENDCHECKPOINT:
+            break;
+          case LogRecordType::NEWPAGE:
+            active_txn_[log_record.txn_id_] = last_lsn;
+            dispatch(log_record.page_id_, log_record, false);
+            if (log_record.prev_page_id_ != INVALID_PAGE_ID) {
+              dispatch(log_record.prev_page_id_, log_record, true);
+            }
+            break;
+          default:
+            active_txn_[log_record.txn_id_] = last_lsn;
+            if (page_of(log_record) != INVALID_PAGE_ID) {
+              dispatch(page_of(log_record), log_record, false);
+            }
+            break;
+        }
+        record_pos += log_record.size_;
+      }
+      pos += frame_size;
+      offset_ += frame_size;
+    }
+    if (segment_ends || frames_end) {
+      if (next_chunk_read.valid()) {
+        next_chunk_read.wait();
+      }
+      chunk = chunk - chunk % LOG_SEGMENT_SIZE + LOG_SEGMENT_SIZE;
+      offset_ = chunk;
+      chunk_read = read_chunk(buffer, chunk);
+      continue;
+    }
+    // Carry the cut frame over to the space before the next chunk.
+    size_t carry = end - pos;
+    memcpy(log_buffers_[1 - buffer] + LogManager::MAX_FRAME_SIZE - carry, pos, carry);
+    buffer = 1 - buffer;
+    chunk = next_chunk;
+    chunk_read = std::move(next_chunk_read);
+  }
+
+  for (size_t i = 0; i < workers.size(); i++) {
+    if (!pending[i].empty()) {
+      hand_off(i);
+    }
+    {
+      std::lock_guard<std::mutex> guard(workers[i]->latch_);
+      workers[i]->done_ = true;
+    }
+    workers[i]->cv_.notify_one();
+  }
+  for (auto &worker : workers) {
+    worker->thread_.join();
+  }
+}
+
+void LogRecovery::redo(const RedoTask &task) {
+  const LogRecord &log_record = task.log_record_;
+  page_id_t page_id = task.link_ ? log_record.prev_page_id_ : page_of(log_record);
+  auto *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    throw Exception("can't fetch page " + std::to_string(page_id) + " to redo");
+  }
+  bool is_dirty = false;
+  if (task.link_) {
+    // Pages are only ever appended to the heap, setting the link is idempotent.
+    if (page->GetNextPageId() == INVALID_PAGE_ID) {
+      page->SetNextPageId(log_record.page_id_);
+      is_dirty = true;
+    }
+  } else if (page->GetLSN() < log_record.lsn_) {
+    RID rid;
+    Tuple old_tuple;
+    switch (log_record.redo_type()) {
+      case LogRecordType::INSERT:
+        page->InsertTuple(log_record.insert_tuple_, &rid, nullptr, nullptr, nullptr);
+        BUSTUB_ASSERT(rid == log_record.insert_rid_, "Redo must insert into the same slot.");
+        break;
+      case LogRecordType::MARKDELETE:
+        page->MarkDelete(log_record.delete_rid_, nullptr, nullptr, nullptr);
+        break;
+      case LogRecordType::APPLYDELETE:
+        page->ApplyDelete(log_record.delete_rid_, nullptr, nullptr);
+        break;
+      case LogRecordType::ROLLBACKDELETE:
+        page->RollbackDelete(log_record.delete_rid_, nullptr, nullptr);
+        break;
+      case LogRecordType::UPDATE: {
+        // The page holds the tuple as it was before the update, the record has the bytes that changed.
+        Tuple new_tuple;
+        if (!page->GetTuple(log_record.update_rid_, &old_tuple, nullptr, nullptr) ||
+            !log_record.ApplyUpdate(old_tuple, &new_tuple)) {
+          buffer_pool_manager_->UnpinPage(page_id, false);
+          throw Exception("can't redo update record " + std::to_string(log_record.lsn_) + ", the tuple differs");
+        }
+        page->UpdateTuple(new_tuple, &old_tuple, log_record.update_rid_, nullptr, nullptr, nullptr);
+        break;
+      }
+      case LogRecordType::NEWPAGE:
+        page->Init(log_record.page_id_, PAGE_SIZE - PAGE_CHECKSUM_SIZE, log_record.prev_page_id_, nullptr, nullptr);
+        break;
+      default:
+        break;
+    }
+    page->SetLSN(log_record.lsn_);
+    is_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(page_id, is_dirty);
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
+ * The records of all the active transactions are undone together, from the last one backwards. Each undone record is
+ * followed by a CLR whose undo next lsn is the record before it, and each rolled back transaction by an ABORT record,
+ * so that the records are not undone again by the next recovery.
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  // The log goes on after the records found by Redo, which are persistent.
+  log_manager_->SetNextLSN(next_lsn_);
+  log_manager_->SetPersistentLSN(next_lsn_ - 1);
+  std::priority_queue<std::pair<lsn_t, txn_id_t>> lsns;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    lsns.emplace(lsn, txn_id);
+  }
+  while (!lsns.empty()) {
+    auto [lsn, txn_id] = lsns.top();
+    lsns.pop();
+    lsn_t undo_next_lsn = INVALID_LSN;
+    auto mapping = lsn_mapping_.find(lsn);
+    // the record is not found if it is in a recycled segment, the transaction started before the checkpoint
+    if (mapping != lsn_mapping_.end()) {
+      auto [frame_offset, record_pos] = mapping->second;
+      size_t records_size;
+      size_t frame_size;
+      const char *records = read_frame(frame_offset, &records_size, &frame_size);
+      LogRecord log_record;
+      if (records == nullptr || !DeserializeLogRecord(records + record_pos, records_size - record_pos, &log_record)) {
+        throw Exception("can't read log record " + std::to_string(lsn) + " to undo");
+      }
+      if (log_record.log_record_type_ == LogRecordType::CLR) {
+        // A previous recovery undid the records after the one to undo next.
+        undo_next_lsn = log_record.undo_next_lsn_;
+      } else {
+        lsn_t clr_lsn = undo(log_record, active_txn_[txn_id]);
+        if (clr_lsn != INVALID_LSN) {
+          active_txn_[txn_id] = clr_lsn;
+        }
+        undo_next_lsn = log_record.prev_lsn_;
+      }
+    }
+    if (undo_next_lsn != INVALID_LSN) {
+      lsns.emplace(undo_next_lsn, txn_id);
+    } else {
+      LogRecord abort_record(txn_id, active_txn_[txn_id], LogRecordType::ABORT);
+      log_manager_->AppendLogRecord(&abort_record);
+    }
+  }
+  release_undone_pages();
+  active_txn_.clear();
+  next_lsn_ = log_manager_->GetNextLSN();
+}
+
+lsn_t LogRecovery::undo(const LogRecord &log_record, lsn_t prev_lsn) {
+  page_id_t page_id = page_of(log_record);
+  if (page_id == INVALID_PAGE_ID || log_record.log_record_type_ == LogRecordType::NEWPAGE) {
+    return INVALID_LSN;
+  }
+  auto *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    throw Exception("can't fetch page " + std::to_string(page_id) + " to undo");
+  }
+  // The operation that undoes the record is logged by the CLR.
+  txn_id_t txn_id = log_record.txn_id_;
+  LogRecord action;
+  RID rid;
+  Tuple old_tuple;
+  switch (log_record.log_record_type_) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(log_record.insert_rid_, nullptr, nullptr);
+      action =
+          LogRecord(txn_id, prev_lsn, LogRecordType::APPLYDELETE, log_record.insert_rid_, log_record.insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(log_record.delete_rid_, nullptr, nullptr);
+      action =
+          LogRecord(txn_id, prev_lsn, LogRecordType::ROLLBACKDELETE, log_record.delete_rid_, log_record.delete_tuple_);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->InsertTuple(log_record.delete_tuple_, &rid, nullptr, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::INSERT, rid, log_record.delete_tuple_);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(log_record.delete_rid_, nullptr, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::MARKDELETE, log_record.delete_rid_, log_record.delete_tuple_);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      if (!page->GetTuple(log_record.update_rid_, &new_tuple, nullptr, nullptr) ||
+          !log_record.RevertUpdate(new_tuple, &old_tuple)) {
+        buffer_pool_manager_->UnpinPage(page_id, false);
+        throw Exception("can't undo update record " + std::to_string(log_record.lsn_) + ", the tuple differs");
+      }
+      page->UpdateTuple(old_tuple, &new_tuple, log_record.update_rid_, nullptr, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::UPDATE, log_record.update_rid_, new_tuple, old_tuple);
+      break;
+    }
+    default:
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      return INVALID_LSN;
+  }
+  LogRecord clr(action, log_record.prev_lsn_);
+  lsn_t lsn = log_manager_->AppendLogRecord(&clr);
+  page->SetLSN(lsn);
+  // The page must not be written before the CLR, it stays pinned until the log is flushed.
+  undone_pages_.push_back(page_id);
+  if (undone_pages_.size() >= std::min(UNDO_BATCH_SIZE, buffer_pool_manager_->GetPoolSize() / 2)) {
+    release_undone_pages();
+  }
+  return lsn;
+}
+
+void LogRecovery::release_undone_pages() {
+  log_manager_->Flush(log_manager_->GetNextLSN() - 1);
+  for (auto page_id : undone_pages_) {
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  }
+  undone_pages_.clear();
+}
 
 }  // namespace bustub
@@ -0,0 +1,325 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_disk_manager.cpp
+//
+// Identification: src/storage/disk/compressed_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/compressed_disk_manager.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/util/crc32c_util.h"
+#include "common/util/lz4_util.h"
+
+namespace bustub {
+
+static constexpr uint32_t IMAGE_MAGIC = 0x505a5442;  // "BTZP"
+
+/**
+ * Constructor: open the image file next to the database file and rebuild the page mapping table
+ */
+CompressedDiskManager::CompressedDiskManager(const std::string &db_file) : DiskManager(db_file) {
+  image_file_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".lz4";
+  image_fd_ = open(image_file_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (image_fd_ < 0) {
+    throw Exception("can't open image file");
+  }
+  LoadImages();
+}
+
+CompressedDiskManager::~CompressedDiskManager() { ShutDown(); }
+
+/**
+ * Close the image file, the database file and the log file
+ */
+void CompressedDiskManager::ShutDown() {
+  // Pending asynchronous requests still need the image file.
+  StopIOThreads();
+  if (image_fd_ >= 0) {
+    close(image_fd_);
+    image_fd_ = -1;
+  }
+  DiskManager::ShutDown();
+}
+
+uint64_t CompressedDiskManager::GetNumSectors(const image_header &header) {
+  return (sizeof(image_header) + header.size_ + SECTOR_SIZE - 1) / SECTOR_SIZE;
+}
+
+uint32_t CompressedDiskManager::GetHeaderChecksum(const image_header &header) {
+  return Crc32cUtil::Crc32c(reinterpret_cast<const char *>(&header), offsetof(image_header, checksum_));
+}
+
+bool CompressedDiskManager::IsValidHeader(const image_header &header, uint64_t num_sectors) {
+  return header.magic_ == IMAGE_MAGIC && header.checksum_ == GetHeaderChecksum(header) && header.size_ <= PAGE_SIZE &&
+         GetNumSectors(header) <= num_sectors;
+}
+
+/**
+ * Scan the image file: the current image of a page is its valid image with the highest version
+ */
+void CompressedDiskManager::LoadImages() {
+  struct stat stat_buf;
+  if (fstat(image_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat image file");
+  }
+  num_sectors_ = (stat_buf.st_size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  // Collect the valid headers first, the ones which are not current are cleared afterwards.
+  std::vector<std::pair<uint64_t, image_header>> images;
+  const size_t chunk_sectors = 2048;
+  std::unique_ptr<char[]> chunk(new char[chunk_sectors * SECTOR_SIZE]);
+  for (uint64_t first = 0; first < num_sectors_; first += chunk_sectors) {
+    size_t size = ReadImageFile(chunk.get(), chunk_sectors * SECTOR_SIZE, first * SECTOR_SIZE);
+    for (size_t i = 0; i * SECTOR_SIZE + sizeof(image_header) <= size; i++) {
+      image_header header;
+      memcpy(&header, chunk.get() + i * SECTOR_SIZE, sizeof(header));
+      if (IsValidHeader(header, num_sectors_ - first - i)) {
+        images.emplace_back(first + i, header);
+      }
+    }
+  }
+  std::vector<uint64_t> versions;
+  for (const auto &[sector, header] : images) {
+    next_version_ = std::max(next_version_, header.version_ + 1);
+    if (!IsAllocated(header.page_id_)) {
+      continue;
+    }
+    auto page_id = static_cast<size_t>(header.page_id_);
+    if (page_id >= extents_.size()) {
+      extents_.resize(page_id + 1, {0, 0});
+      versions.resize(page_id + 1, 0);
+    }
+    if (header.version_ > versions[page_id]) {
+      versions[page_id] = header.version_;
+      extents_[page_id] = {sector, GetNumSectors(header)};
+    }
+  }
+  sector_bitmap_.resize((num_sectors_ + 63) / 64, 0);
+  for (const auto &extent : extents_) {
+    for (uint64_t sector = extent.sector_; sector < extent.sector_ + extent.num_sectors_; sector++) {
+      sector_bitmap_[sector / 64] |= uint64_t{1} << (sector % 64);
+    }
+  }
+  // Stale images are left behind by a crash between writing a moved image and clearing the old one, or between
+  // clearing the image of a deallocated page and freeing the page.
+  for (const auto &[sector, header] : images) {
+    if ((sector_bitmap_[sector / 64] >> (sector % 64) & 1) == 0) {
+      ClearHeader({sector, GetNumSectors(header)});
+    }
+  }
+}
+
+uint64_t CompressedDiskManager::AllocateSectors(uint64_t num_sectors) {
+  // First fit, a run of free sectors at the end of the file is extended.
+  uint64_t run = 0;
+  uint64_t sector = sector_hint_;
+  for (; sector < num_sectors_ && run < num_sectors; sector++) {
+    bool used = (sector_bitmap_[sector / 64] >> (sector % 64) & 1) != 0;
+    run = used ? 0 : run + 1;
+  }
+  uint64_t start = sector - run;
+  num_sectors_ = std::max(num_sectors_, start + num_sectors);
+  sector_bitmap_.resize((num_sectors_ + 63) / 64, 0);
+  for (sector = start; sector < start + num_sectors; sector++) {
+    sector_bitmap_[sector / 64] |= uint64_t{1} << (sector % 64);
+  }
+  if (start == sector_hint_) {
+    sector_hint_ = start + num_sectors;
+  }
+  return start;
+}
+
+void CompressedDiskManager::FreeSectors(const image_extent &extent) {
+  for (uint64_t sector = extent.sector_; sector < extent.sector_ + extent.num_sectors_; sector++) {
+    sector_bitmap_[sector / 64] &= ~(uint64_t{1} << (sector % 64));
+  }
+  sector_hint_ = std::min(sector_hint_, extent.sector_);
+}
+
+void CompressedDiskManager::ClearHeader(const image_extent &extent) {
+  char zeros[sizeof(image_header)] = {0};
+  WriteImageFile(zeros, sizeof(zeros), extent.sector_ * SECTOR_SIZE);
+}
+
+/**
+ * Compress the page with its checksum and write the image, in place if it takes as many sectors as the current one
+ */
+void CompressedDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  thread_local char page[PAGE_SIZE];
+  thread_local char image[MAX_IMAGE_SECTORS * SECTOR_SIZE];
+  memcpy(page, page_data, CHECKSUM_OFFSET);
+  StampChecksum(page);
+
+  image_header header;
+  header.magic_ = IMAGE_MAGIC;
+  header.page_id_ = page_id;
+  // Compression has to save at least a byte, or the page is stored as is.
+  size_t size = Lz4Util::Compress(page, PAGE_SIZE, image + sizeof(image_header), PAGE_SIZE - 1);
+  if (size > 0) {
+    header.size_ = size;
+    header.flags_ = IMAGE_COMPRESSED;
+  } else {
+    memcpy(image + sizeof(image_header), page, PAGE_SIZE);
+    header.size_ = PAGE_SIZE;
+    header.flags_ = 0;
+  }
+  uint64_t num_sectors = GetNumSectors(header);
+  // Zero the slack after the image, the sectors may hold stale data.
+  size_t image_size = sizeof(image_header) + header.size_;
+  memset(image + image_size, 0, num_sectors * SECTOR_SIZE - image_size);
+
+  image_extent old_extent;
+  image_extent extent;
+  {
+    std::lock_guard<std::mutex> guard(map_latch_);
+    header.version_ = next_version_++;
+    if (static_cast<size_t>(page_id) >= extents_.size()) {
+      extents_.resize(page_id + 1, {0, 0});
+    }
+    old_extent = extents_[page_id];
+    extent = old_extent;
+    if (old_extent.num_sectors_ != num_sectors) {
+      extent = {AllocateSectors(num_sectors), num_sectors};
+      extents_[page_id] = extent;
+    }
+  }
+  header.checksum_ = GetHeaderChecksum(header);
+  memcpy(image, &header, sizeof(header));
+  num_writes_ += 1;
+  WriteImageFile(image, num_sectors * SECTOR_SIZE, extent.sector_ * SECTOR_SIZE);
+
+  // The old image keeps its sectors until its header is cleared.
+  if (old_extent.num_sectors_ != 0 && old_extent.sector_ != extent.sector_) {
+    ClearHeader(old_extent);
+    std::lock_guard<std::mutex> guard(map_latch_);
+    FreeSectors(old_extent);
+  }
+}
+
+/**
+ * Read the image of the page and decompress it, pages without an image read as zeros
+ */
+void CompressedDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  thread_local char image[MAX_IMAGE_SECTORS * SECTOR_SIZE];
+  image_extent extent{0, 0};
+  {
+    std::lock_guard<std::mutex> guard(map_latch_);
+    if (page_id >= 0 && static_cast<size_t>(page_id) < extents_.size()) {
+      extent = extents_[page_id];
+    }
+  }
+  if (extent.num_sectors_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  size_t size = ReadImageFile(image, extent.num_sectors_ * SECTOR_SIZE, extent.sector_ * SECTOR_SIZE);
+  num_bytes_read_ += size;
+  image_header header;
+  memcpy(&header, image, sizeof(header));
+  bool decoded = size == extent.num_sectors_ * SECTOR_SIZE && IsValidHeader(header, extent.num_sectors_) &&
+                 header.page_id_ == page_id;
+  if (decoded && (header.flags_ & IMAGE_COMPRESSED) != 0) {
+    decoded = Lz4Util::Decompress(image + sizeof(image_header), header.size_, page_data, PAGE_SIZE);
+  } else if (decoded) {
+    decoded = header.size_ == PAGE_SIZE;
+    memcpy(page_data, image + sizeof(image_header), PAGE_SIZE);
+  }
+  if (!decoded || !VerifyChecksum(page_data)) {
+    throw Exception("corrupted image of page " + std::to_string(page_id));
+  }
+  memset(page_data + CHECKSUM_OFFSET, 0, PAGE_CHECKSUM_SIZE);
+}
+
+/**
+ * Free the image of the page, then the page
+ */
+void CompressedDiskManager::DeallocatePage(page_id_t page_id) {
+  image_extent extent{0, 0};
+  {
+    std::lock_guard<std::mutex> guard(map_latch_);
+    if (page_id >= 0 && static_cast<size_t>(page_id) < extents_.size()) {
+      extent = extents_[page_id];
+      extents_[page_id] = {0, 0};
+    }
+  }
+  if (extent.num_sectors_ != 0) {
+    ClearHeader(extent);
+    std::lock_guard<std::mutex> guard(map_latch_);
+    FreeSectors(extent);
+  }
+  DiskManager::DeallocatePage(page_id);
+}
+
+void CompressedDiskManager::SyncDbFile() {
+  DiskManager::SyncDbFile();
+  if (fsync(image_fd_) != 0) {
+    throw Exception("can't sync image file");
+  }
+}
+
+void CompressedDiskManager::ShrinkFile() {
+  DiskManager::ShrinkFile();
+  std::lock_guard<std::mutex> guard(map_latch_);
+  while (num_sectors_ > 0 && (sector_bitmap_[(num_sectors_ - 1) / 64] >> ((num_sectors_ - 1) % 64) & 1) == 0) {
+    num_sectors_--;
+  }
+  sector_bitmap_.resize((num_sectors_ + 63) / 64);
+  sector_hint_ = std::min(sector_hint_, num_sectors_);
+  if (ftruncate(image_fd_, num_sectors_ * SECTOR_SIZE) != 0) {
+    LOG_DEBUG("I/O error while truncating the image file");
+  }
+}
+
+void CompressedDiskManager::WriteImageFile(const char *data, size_t size, size_t offset) {
+  num_bytes_written_ += size;
+  size_t written = 0;
+  while (written < size) {
+    ssize_t rc = pwrite(image_fd_, data + written, size - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+}
+
+size_t CompressedDiskManager::ReadImageFile(char *data, size_t size, size_t offset) {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t rc = pread(image_fd_, data + read_count, size - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      if (rc < 0) {
+        LOG_DEBUG("I/O error while reading");
+      }
+      break;
+    }
+    read_count += rc;
+  }
+  return read_count;
+}
+
+}  // namespace bustub
@@ -12,8 +12,12 @@
 
 #include "storage/disk/disk_manager.h"
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -22,37 +26,39 @@
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c_util.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/**
+ * Layout of the superblock at the start of the database file
+ */
+static constexpr char DB_FILE_MAGIC[8] = {'B', 'U', 'S', 'T', 'U', 'B', 'D', 'B'};
+static constexpr uint32_t DB_FILE_VERSION = 2;
+struct Superblock {
+  char magic_[8];
+  uint32_t version_;
+  uint32_t page_size_;
+  uint32_t pages_per_bitmap_;
+  // the last checkpoint, zeros if there is none
+  lsn_t checkpoint_lsn_;
+  uint64_t checkpoint_offset_;
+};
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
 DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
-  std::string::size_type n = file_name_.rfind('.');
-  if (n == std::string::npos) {
+    : file_name_(db_file), alloc_hint_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+  log_name_ = GetLogName(file_name_);
+  if (log_name_.empty()) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
-
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
-  }
+  OpenLog();
 
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   // directory or file does not exist
@@ -68,59 +74,364 @@ DiskManager::DiskManager(const std::string &db_file)
     }
   }
   buffer_used = nullptr;
+  OpenDbFile();
+}
+
+void DiskManager::OpenDbFile() {
+  char page[PAGE_SIZE] = {0};
+  auto *superblock = reinterpret_cast<Superblock *>(page);
+  int file_size = GetFileSize(file_name_);
+  if (file_size <= 0) {
+    WriteSuperblock();
+    return;
+  }
+  // The page size is checked before the checksum, which sits at the end of a page of the size the file was created
+  // with.
+  size_t read_count = ReadDbFile(page, PAGE_SIZE, 0);
+  if (read_count < sizeof(Superblock) || memcmp(superblock->magic_, DB_FILE_MAGIC, 8) != 0 ||
+      superblock->version_ != DB_FILE_VERSION) {
+    throw Exception("not a database file");
+  }
+  if (superblock->page_size_ != PAGE_SIZE || superblock->pages_per_bitmap_ != PAGES_PER_BITMAP) {
+    throw Exception("database file was created with page size " + std::to_string(superblock->page_size_) +
+                    ", this build uses " + std::to_string(PAGE_SIZE));
+  }
+  if (read_count != PAGE_SIZE || !VerifyChecksum(page)) {
+    throw Exception("database file has a corrupted superblock");
+  }
+  checkpoint_offset_ = superblock->checkpoint_offset_;
+  checkpoint_lsn_ = superblock->checkpoint_lsn_;
+  // Groups whose bitmap page is not in the file have no allocated pages.
+  for (size_t group = 0; GetBitmapOffset(group) < static_cast<size_t>(file_size); ++group) {
+    memset(page, 0, PAGE_SIZE);
+    ReadDbFile(page, PAGE_SIZE, GetBitmapOffset(group));
+    if (!VerifyChecksum(page)) {
+      throw Exception("database file has a corrupted allocation bitmap");
+    }
+    page_bitmap_.resize((group + 1) * WORDS_PER_BITMAP, 0);
+    memcpy(&page_bitmap_[group * WORDS_PER_BITMAP], page, WORDS_PER_BITMAP * sizeof(uint64_t));
+  }
+}
+
+void DiskManager::WriteSuperblock() {
+  char page[PAGE_SIZE] = {0};
+  auto *superblock = reinterpret_cast<Superblock *>(page);
+  memcpy(superblock->magic_, DB_FILE_MAGIC, sizeof(DB_FILE_MAGIC));
+  superblock->version_ = DB_FILE_VERSION;
+  superblock->page_size_ = PAGE_SIZE;
+  superblock->pages_per_bitmap_ = PAGES_PER_BITMAP;
+  superblock->checkpoint_lsn_ = checkpoint_lsn_;
+  superblock->checkpoint_offset_ = checkpoint_offset_;
+  StampChecksum(page);
+  WriteDbFile(page, PAGE_SIZE, 0);
+}
+
+size_t DiskManager::GetBitmapOffset(size_t group) { return (1 + group * (PAGES_PER_BITMAP + 1)) * PAGE_SIZE; }
+
+size_t DiskManager::GetPageOffset(page_id_t page_id) {
+  auto group = static_cast<size_t>(page_id) / PAGES_PER_BITMAP;
+  return GetBitmapOffset(group) + (1 + static_cast<size_t>(page_id) % PAGES_PER_BITMAP) * PAGE_SIZE;
+}
+
+void DiskManager::WriteBitmap(size_t group) {
+  char page[PAGE_SIZE] = {0};
+  memcpy(page, &page_bitmap_[group * WORDS_PER_BITMAP], WORDS_PER_BITMAP * sizeof(uint64_t));
+  StampChecksum(page);
+  WriteDbFile(page, PAGE_SIZE, GetBitmapOffset(group));
+}
+
+void DiskManager::StampChecksum(char *page_data) {
+  uint32_t checksum = Crc32cUtil::Crc32c(page_data, CHECKSUM_OFFSET);
+  memcpy(page_data + CHECKSUM_OFFSET, &checksum, sizeof(checksum));
+}
+
+bool DiskManager::VerifyChecksum(const char *page_data) {
+  uint32_t checksum;
+  memcpy(&checksum, page_data + CHECKSUM_OFFSET, sizeof(checksum));
+  if (checksum == Crc32cUtil::Crc32c(page_data, CHECKSUM_OFFSET)) {
+    return true;
+  }
+  // Pages that were allocated but never written read back as zeros.
+  return checksum == 0 && std::all_of(page_data, page_data + CHECKSUM_OFFSET, [](char c) { return c == 0; });
 }
 
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  StopIOThreads();
   db_io_.close();
-  log_io_.close();
+  CloseLog();
+}
+
+DiskManager::~DiskManager() {
+  StopIOThreads();
+  CloseLog();
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+  // Stamp the checksum on a copy, the caller may share the page with readers.
+  alignas(PAGE_SIZE) thread_local char stamped[PAGE_SIZE];
+  memcpy(stamped, page_data, CHECKSUM_OFFSET);
+  StampChecksum(stamped);
+  size_t offset = GetPageOffset(page_id);
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
-  }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  WriteDbFile(stamped, PAGE_SIZE, offset);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  size_t offset = GetPageOffset(page_id);
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (static_cast<int64_t>(offset) > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error reading past end of file");
     // std::cerr << "I/O error while reading" << std::endl;
+    memset(page_data, 0, PAGE_SIZE);
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
-      return;
-    }
     // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
+    size_t read_count = ReadDbFile(page_data, PAGE_SIZE, offset);
     if (read_count < PAGE_SIZE) {
       LOG_DEBUG("Read less than a page");
-      db_io_.clear();
       // std::cerr << "Read less than a page" << std::endl;
       memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
+    if (!VerifyChecksum(page_data)) {
+      throw Exception("checksum mismatch on page " + std::to_string(page_id));
+    }
+    memset(page_data + CHECKSUM_OFFSET, 0, PAGE_CHECKSUM_SIZE);
+  }
+}
+
+/**
+ * Write a page on one of the I/O threads
+ */
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  return RunAsync([this, page_id, page_data] { WritePage(page_id, page_data); });
+}
+
+/**
+ * Read a page on one of the I/O threads
+ */
+std::future<void> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  return RunAsync([this, page_id, page_data] { ReadPage(page_id, page_data); });
+}
+
+/**
+ * Queue a task for the I/O threads, starting them if needed
+ */
+std::future<void> DiskManager::RunAsync(std::function<void()> task) {
+  std::packaged_task<void()> packaged_task(std::move(task));
+  auto future = packaged_task.get_future();
+  {
+    std::lock_guard<std::mutex> guard(io_tasks_latch_);
+    if (io_threads_.empty()) {
+      stop_io_threads_ = false;
+      for (size_t i = 0; i < NUM_IO_THREADS; ++i) {
+        io_threads_.emplace_back([this] {
+          std::unique_lock<std::mutex> lock(io_tasks_latch_);
+          while (true) {
+            io_tasks_cv_.wait(lock, [this] { return stop_io_threads_ || !io_tasks_.empty(); });
+            // drain the queue before stopping
+            if (io_tasks_.empty()) {
+              return;
+            }
+            auto next_task = std::move(io_tasks_.front());
+            io_tasks_.pop_front();
+            lock.unlock();
+            next_task();
+            lock.lock();
+          }
+        });
+      }
+    }
+    io_tasks_.push_back(std::move(packaged_task));
+  }
+  io_tasks_cv_.notify_one();
+  return future;
+}
+
+/**
+ * Let the I/O threads finish the queued tasks and join them
+ */
+void DiskManager::StopIOThreads() {
+  std::vector<std::thread> io_threads;
+  {
+    std::lock_guard<std::mutex> guard(io_tasks_latch_);
+    stop_io_threads_ = true;
+    io_threads.swap(io_threads_);
+  }
+  io_tasks_cv_.notify_all();
+  for (auto &io_thread : io_threads) {
+    io_thread.join();
+  }
+}
+
+/**
+ * Write raw bytes into the database file through the shared stream
+ */
+void DiskManager::WriteDbFile(const char *data, size_t size, size_t offset) {
+  std::lock_guard<std::mutex> guard(db_io_latch_);
+  // set write cursor to offset
+  db_io_.seekp(offset);
+  db_io_.write(data, size);
+  // check for I/O error
+  if (db_io_.bad()) {
+    throw Exception("I/O error while writing the db file at offset " + std::to_string(offset));
+  }
+  // needs to flush to keep disk file in sync
+  db_io_.flush();
+}
+
+/**
+ * Read raw bytes from the database file through the shared stream
+ */
+size_t DiskManager::ReadDbFile(char *data, size_t size, size_t offset) {
+  std::lock_guard<std::mutex> guard(db_io_latch_);
+  // set read cursor to offset
+  db_io_.seekp(offset);
+  db_io_.read(data, size);
+  if (db_io_.bad()) {
+    throw Exception("I/O error while reading the db file at offset " + std::to_string(offset));
+  }
+  auto read_count = static_cast<size_t>(db_io_.gcount());
+  if (read_count < size) {
+    db_io_.clear();
+  }
+  return read_count;
+}
+
+std::string DiskManager::GetLogName(const std::string &db_file) {
+  std::string::size_type n = db_file.rfind('.');
+  return n == std::string::npos ? std::string() : db_file.substr(0, n) + ".log";
+}
+
+std::string DiskManager::GetLogSegmentName(const std::string &log_name, size_t segment, bool spare) {
+  return log_name + "." + std::to_string(segment) + (spare ? ".spare" : "");
+}
+
+/**
+ * List the directory of the log file for "<log>.<segment>" and "<log>.<segment>.spare"
+ */
+void DiskManager::FindLogFiles(const std::string &log_name, std::vector<size_t> *segments,
+                               std::vector<size_t> *spares) {
+  std::string::size_type n = log_name.rfind('/');
+  std::string dir_name = n == std::string::npos ? "." : log_name.substr(0, n + 1);
+  std::string prefix = (n == std::string::npos ? log_name : log_name.substr(n + 1)) + ".";
+  DIR *dir = opendir(dir_name.c_str());
+  if (dir == nullptr) {
+    throw Exception("can't open the directory of the log");
+  }
+  while (auto *entry = readdir(dir)) {
+    std::string name(entry->d_name);
+    if (name.compare(0, prefix.size(), prefix) != 0) {
+      continue;
+    }
+    std::string suffix = name.substr(prefix.size());
+    bool spare = suffix.size() > 6 && suffix.compare(suffix.size() - 6, 6, ".spare") == 0;
+    if (spare) {
+      suffix.resize(suffix.size() - 6);
+    }
+    if (suffix.empty() || !std::all_of(suffix.begin(), suffix.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+      continue;
+    }
+    (spare ? spares : segments)->push_back(std::stoull(suffix));
+  }
+  closedir(dir);
+  std::sort(segments->begin(), segments->end());
+  std::sort(spares->begin(), spares->end());
+}
+
+void DiskManager::RemoveLogFiles(const std::string &db_file) {
+  std::string log_name = GetLogName(db_file);
+  std::vector<size_t> segments;
+  std::vector<size_t> spares;
+  FindLogFiles(log_name, &segments, &spares);
+  for (size_t segment : segments) {
+    remove(GetLogSegmentName(log_name, segment, false).c_str());
+  }
+  for (size_t segment : spares) {
+    remove(GetLogSegmentName(log_name, segment, true).c_str());
+  }
+}
+
+/**
+ * Open the segments left by earlier runs, they have to be consecutive
+ */
+void DiskManager::OpenLog() {
+  std::vector<size_t> segments;
+  FindLogFiles(log_name_, &segments, &spare_log_segments_);
+  if (segments.empty()) {
+    return;
+  }
+  log_start_segment_ = segments.front();
+  for (size_t i = 0; i < segments.size(); i++) {
+    if (segments[i] != log_start_segment_ + i) {
+      CloseLog();
+      throw Exception("log segment " + std::to_string(log_start_segment_ + i) + " is missing");
+    }
+    int fd = open(GetLogSegmentName(log_name_, segments[i], false).c_str(), O_RDWR);
+    if (fd < 0) {
+      CloseLog();
+      throw Exception("can't open log segment " + std::to_string(segments[i]));
+    }
+    log_fds_.push_back(fd);
+  }
+  // The end of the records in the last segment is not known here, the next write starts a new one.
+  log_offset_ = (segments.back() + 1) * LOG_SEGMENT_SIZE;
+}
+
+/**
+ * Reuse the blocks of a spare file, or preallocate a new file so that writing it does not extend it
+ */
+void DiskManager::AddLogSegment() {
+  size_t segment = log_start_segment_ + log_fds_.size();
+  std::string name = GetLogSegmentName(log_name_, segment, false);
+  if (!spare_log_segments_.empty()) {
+    std::string spare_name = GetLogSegmentName(log_name_, spare_log_segments_.back(), true);
+    if (rename(spare_name.c_str(), name.c_str()) != 0) {
+      throw Exception("can't reuse spare log segment " + spare_name);
+    }
+    spare_log_segments_.pop_back();
+  }
+  int fd = open(name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    throw Exception("can't create log segment " + name);
+  }
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) != 0 || stat_buf.st_size < LOG_SEGMENT_SIZE) {
+    if (fallocate(fd, 0, 0, LOG_SEGMENT_SIZE) != 0 && ftruncate(fd, LOG_SEGMENT_SIZE) != 0) {
+      close(fd);
+      throw Exception("can't allocate log segment " + name);
+    }
+    // The allocation changes the metadata of the file, once per segment.
+    fsync(fd);
+  }
+  SyncLogDirectory();
+  log_fds_.push_back(fd);
+}
+
+void DiskManager::CloseLog() {
+  std::lock_guard<std::mutex> guard(log_latch_);
+  for (int fd : log_fds_) {
+    close(fd);
+  }
+  log_fds_.clear();
+}
+
+void DiskManager::SyncLogDirectory() {
+  std::string::size_type n = log_name_.rfind('/');
+  std::string dir_name = n == std::string::npos ? "." : log_name_.substr(0, n + 1);
+  int dir_fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir_fd < 0 || fsync(dir_fd) != 0) {
+    LOG_DEBUG("I/O error while syncing the log directory");
+  }
+  if (dir_fd >= 0) {
+    close(dir_fd);
   }
 }
 
@@ -145,16 +456,36 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
+  std::lock_guard<std::mutex> guard(log_latch_);
+  if (log_failed_) {
+    throw Exception("can't write log after a failed log write");
+  }
+  // records do not span segments
+  if (log_offset_ % LOG_SEGMENT_SIZE + size > static_cast<size_t>(LOG_SEGMENT_SIZE)) {
+    log_offset_ += LOG_SEGMENT_SIZE - log_offset_ % LOG_SEGMENT_SIZE;
+  }
+  size_t segment = log_offset_ / LOG_SEGMENT_SIZE;
+  if (segment == log_start_segment_ + log_fds_.size()) {
+    AddLogSegment();
+  }
+  int fd = log_fds_[segment - log_start_segment_];
   // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
-    return;
+  for (int written = 0; written < size;) {
+    ssize_t rc = pwrite(fd, log_data + written, size - written, log_offset_ % LOG_SEGMENT_SIZE + written);
+    // check for I/O error
+    if (rc <= 0) {
+      log_failed_ = true;
+      throw Exception("I/O error while writing log segment " + std::to_string(segment));
+    }
+    written += rc;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
+  // the segment is preallocated, only its data needs to be synced
+  if (fdatasync(fd) != 0) {
+    // The kernel may have dropped the dirty data, syncing again could succeed without it.
+    log_failed_ = true;
+    throw Exception("I/O error while syncing log segment " + std::to_string(segment));
+  }
+  log_offset_ += size;
   flush_log_ = false;
 }
 
@@ -163,41 +494,186 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
-    // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+bool DiskManager::ReadLog(char *log_data, int size, size_t offset) {
+  std::lock_guard<std::mutex> guard(log_latch_);
+  size_t segment = offset / LOG_SEGMENT_SIZE;
+  if (offset >= log_offset_ || segment < log_start_segment_ || segment >= log_start_segment_ + log_fds_.size()) {
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
+  // if the segment or the log ends before reading "size"
+  size_t readable = std::min({static_cast<size_t>(size), LOG_SEGMENT_SIZE - offset % LOG_SEGMENT_SIZE,
+                              log_offset_ - offset});
+  ssize_t read_count = pread(log_fds_[segment - log_start_segment_], log_data, readable, offset % LOG_SEGMENT_SIZE);
+  if (read_count < 0) {
     LOG_DEBUG("I/O error while reading log");
     return false;
   }
-  // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
-  if (read_count < size) {
-    log_io_.clear();
-    memset(log_data + read_count, 0, size - read_count);
+  memset(log_data + read_count, 0, size - read_count);
+  return true;
+}
+
+/**
+ * The pages written before the checkpoint are made durable first, recovery relies on them.
+ */
+void DiskManager::SetCheckpoint(size_t offset, lsn_t lsn) {
+  SyncDbFile();
+  {
+    std::lock_guard<std::mutex> guard(checkpoint_latch_);
+    checkpoint_offset_ = offset;
+    checkpoint_lsn_ = lsn;
+    WriteSuperblock();
   }
+  SyncDbFile();
+}
 
-  return true;
+bool DiskManager::GetCheckpoint(size_t *offset, lsn_t *lsn) {
+  std::lock_guard<std::mutex> guard(checkpoint_latch_);
+  *offset = checkpoint_offset_;
+  *lsn = checkpoint_lsn_;
+  return checkpoint_offset_ != 0;
+}
+
+/**
+ * Any descriptor of the file syncs the data written through the stream once the stream is flushed
+ */
+void DiskManager::SyncDbFile() {
+  {
+    std::lock_guard<std::mutex> guard(db_io_latch_);
+    db_io_.flush();
+  }
+  int fd = open(file_name_.c_str(), O_RDONLY);
+  if (fd < 0 || fsync(fd) != 0) {
+    throw Exception("can't sync db file");
+  }
+  close(fd);
+}
+
+size_t DiskManager::GetLogStartOffset() {
+  std::lock_guard<std::mutex> guard(log_latch_);
+  return log_start_segment_ * LOG_SEGMENT_SIZE;
+}
+
+size_t DiskManager::GetLogOffset() {
+  std::lock_guard<std::mutex> guard(log_latch_);
+  return log_offset_;
+}
+
+/**
+ * Rename the segments before the offset to spare files, up to MAX_SPARE_LOG_SEGMENTS, and remove the others
+ */
+void DiskManager::RecycleLog(size_t offset) {
+  std::lock_guard<std::mutex> guard(log_latch_);
+  offset = std::min(offset, log_offset_);
+  bool recycled = false;
+  while (!log_fds_.empty() && (log_start_segment_ + 1) * LOG_SEGMENT_SIZE <= offset) {
+    close(log_fds_.front());
+    log_fds_.pop_front();
+    std::string name = GetLogSegmentName(log_name_, log_start_segment_, false);
+    if (spare_log_segments_.size() < MAX_SPARE_LOG_SEGMENTS &&
+        rename(name.c_str(), GetLogSegmentName(log_name_, log_start_segment_, true).c_str()) == 0) {
+      spare_log_segments_.push_back(log_start_segment_);
+    } else {
+      remove(name.c_str());
+    }
+    log_start_segment_++;
+    recycled = true;
+  }
+  if (recycled) {
+    SyncLogDirectory();
+  }
 }
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Take the lowest free page, adding a new group if all of them are full
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  size_t word = alloc_hint_;
+  while (word < page_bitmap_.size() && page_bitmap_[word] == ~uint64_t{0}) {
+    word++;
+  }
+  if (word == page_bitmap_.size()) {
+    page_bitmap_.resize(page_bitmap_.size() + WORDS_PER_BITMAP, 0);
+  }
+  auto bit = static_cast<size_t>(__builtin_ctzll(~page_bitmap_[word]));
+  page_bitmap_[word] |= uint64_t{1} << bit;
+  alloc_hint_ = word;
+  auto page_id = static_cast<page_id_t>(word * 64 + bit);
+  WriteBitmap(page_id / PAGES_PER_BITMAP);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * The page becomes free for the next allocation
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  size_t word = static_cast<size_t>(page_id) / 64;
+  uint64_t mask = uint64_t{1} << (page_id % 64);
+  if (page_id < 0 || word >= page_bitmap_.size() || (page_bitmap_[word] & mask) == 0) {
+    LOG_DEBUG("deallocating page %d which is not allocated", page_id);
+    return;
+  }
+  page_bitmap_[word] &= ~mask;
+  alloc_hint_ = std::min(alloc_hint_, word);
+  WriteBitmap(page_id / PAGES_PER_BITMAP);
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  size_t word = static_cast<size_t>(page_id) / 64;
+  return page_id >= 0 && word < page_bitmap_.size() && (page_bitmap_[word] >> (page_id % 64) & 1) != 0;
+}
+
+/**
+ * Truncate the file after the last allocated page and punch holes for the free pages before it
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::ShrinkFile() {
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  auto num_pages = static_cast<page_id_t>(page_bitmap_.size() * 64);
+  page_id_t last_page_id = INVALID_PAGE_ID;
+  for (page_id_t page_id = num_pages - 1; page_id >= 0; page_id--) {
+    if ((page_bitmap_[page_id / 64] >> (page_id % 64) & 1) != 0) {
+      last_page_id = page_id;
+      break;
+    }
+  }
+  // Keep the superblock and, if there are allocated pages, everything up to the last one.
+  size_t size = last_page_id == INVALID_PAGE_ID ? PAGE_SIZE : GetPageOffset(last_page_id) + PAGE_SIZE;
+  if (static_cast<int64_t>(size) < GetFileSize(file_name_) && truncate(file_name_.c_str(), size) != 0) {
+    LOG_DEBUG("I/O error while truncating");
+  }
+  // The bitmaps of the groups after the last page are gone with the truncation, they only had free pages.
+  size_t num_groups = last_page_id == INVALID_PAGE_ID ? 0 : last_page_id / PAGES_PER_BITMAP + 1;
+  page_bitmap_.resize(num_groups * WORDS_PER_BITMAP);
+  alloc_hint_ = std::min(alloc_hint_, page_bitmap_.size());
+
+  int fd = open(file_name_.c_str(), O_RDWR);
+  if (fd < 0) {
+    LOG_DEBUG("I/O error while opening the file to punch holes");
+    return;
+  }
+  page_id_t run_start = INVALID_PAGE_ID;
+  for (page_id_t page_id = 0; page_id <= last_page_id; page_id++) {
+    bool is_free = (page_bitmap_[page_id / 64] >> (page_id % 64) & 1) == 0;
+    // A run of free pages ends at an allocated page or at the end of a group, whose next bitmap page has to stay.
+    if (is_free && run_start == INVALID_PAGE_ID) {
+      run_start = page_id;
+    }
+    bool run_ends = !is_free || (page_id + 1) % PAGES_PER_BITMAP == 0;
+    if (run_start != INVALID_PAGE_ID && run_ends) {
+      page_id_t run_end = is_free ? page_id + 1 : page_id;
+      size_t offset = GetPageOffset(run_start);
+      if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, (run_end - run_start) * PAGE_SIZE) != 0) {
+        LOG_DEBUG("cannot punch a hole for the free pages");
+      }
+      run_start = INVALID_PAGE_ID;
+    }
+  }
+  close(fd);
+}
 
 /**
  * Returns number of flushes made so far
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_disk_manager.cpp
+//
+// Identification: src/storage/disk/mmap_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/mmap_disk_manager.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+// Allocated pages past the end of the file were never written and read as zeros.
+alignas(PAGE_SIZE) static const char ZERO_PAGE[PAGE_SIZE] = {0};
+
+/**
+ * Constructor: map the whole database file read-only
+ */
+MmapDiskManager::MmapDiskManager(const std::string &db_file) : DiskManager(db_file) {
+  db_fd_ = open(file_name_.c_str(), O_RDONLY);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    close(db_fd_);
+    throw Exception("can't stat db file");
+  }
+  mapping_size_ = stat_buf.st_size;
+  void *mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, db_fd_, 0);
+  if (mapping == MAP_FAILED) {
+    close(db_fd_);
+    throw Exception("can't map db file");
+  }
+  mapping_ = static_cast<char *>(mapping);
+
+  for (size_t word = page_bitmap_.size(); word > 0; --word) {
+    if (page_bitmap_[word - 1] != 0) {
+      num_pages_ = word * 64 - __builtin_clzll(page_bitmap_[word - 1]);
+      break;
+    }
+  }
+  verified_ = std::vector<std::atomic<bool>>(num_pages_);
+}
+
+MmapDiskManager::~MmapDiskManager() { ShutDown(); }
+
+/**
+ * Unmap and close the database file, the log file and the file streams
+ */
+void MmapDiskManager::ShutDown() {
+  StopIOThreads();
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+  }
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  DiskManager::ShutDown();
+}
+
+const char *MmapDiskManager::GetPageData(page_id_t page_id) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_pages_ || !IsAllocated(page_id)) {
+    return nullptr;
+  }
+  size_t offset = GetPageOffset(page_id);
+  if (offset + PAGE_SIZE > mapping_size_) {
+    return ZERO_PAGE;
+  }
+  return mapping_ + offset;
+}
+
+void MmapDiskManager::VerifyPage(page_id_t page_id) {
+  auto &verified = verified_[page_id];
+  if (verified.load(std::memory_order_acquire)) {
+    return;
+  }
+  if (!VerifyChecksum(GetPageData(page_id))) {
+    throw Exception("checksum mismatch on page " + std::to_string(page_id));
+  }
+  verified.store(true, std::memory_order_release);
+}
+
+void MmapDiskManager::WriteDbFile(const char *data, size_t size, size_t offset) {
+  throw Exception("db file is mapped read-only");
+}
+
+}  // namespace bustub
@@ -0,0 +1,134 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posix_disk_manager.cpp
+//
+// Identification: src/storage/disk/posix_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/posix_disk_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+/**
+ * Constructor: open the database file with a raw file descriptor, the base class takes care of the log file
+ */
+PosixDiskManager::PosixDiskManager(const std::string &db_file, bool direct_io)
+    : DiskManager(db_file), db_fd_(-1), direct_io_(direct_io) {
+  // The base class opened (and created) the file as a stream, we do not need it.
+  db_io_.close();
+  int flags = O_RDWR | O_CREAT;
+  if (direct_io_) {
+    db_fd_ = open(db_file.c_str(), flags | O_DIRECT, 0644);
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT is not supported for %s", db_file.c_str());
+      direct_io_ = false;
+    }
+  }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), flags, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+}
+
+PosixDiskManager::~PosixDiskManager() { ShutDown(); }
+
+/**
+ * Close the file descriptor and the log file
+ */
+void PosixDiskManager::ShutDown() {
+  // Pending asynchronous requests still need the file descriptor.
+  StopIOThreads();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  DiskManager::ShutDown();
+}
+
+bool PosixDiskManager::IsAligned(const char *data, size_t size) const {
+  return !direct_io_ ||
+         (reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0 && size % DIRECT_IO_ALIGNMENT == 0);
+}
+
+/**
+ * Write raw bytes with pwrite, retrying short writes
+ */
+void PosixDiskManager::WriteDbFile(const char *data, size_t size, size_t offset) {
+  std::unique_ptr<char, decltype(&free)> bounce(nullptr, &free);
+  if (!IsAligned(data, size)) {
+    // O_DIRECT writes whole blocks: the size has to be aligned already, only the buffer may need to move.
+    assert(size % DIRECT_IO_ALIGNMENT == 0 && offset % DIRECT_IO_ALIGNMENT == 0);
+    bounce.reset(static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, size)));
+    memcpy(bounce.get(), data, size);
+    data = bounce.get();
+  }
+  size_t written = 0;
+  while (written < size) {
+    ssize_t rc = pwrite(db_fd_, data + written, size - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      throw Exception("I/O error while writing the db file at offset " + std::to_string(offset));
+    }
+    written += rc;
+  }
+}
+
+/**
+ * Read raw bytes with pread, retrying short reads until the end of the file
+ */
+size_t PosixDiskManager::ReadDbFile(char *data, size_t size, size_t offset) {
+  char *target = data;
+  size_t target_size = size;
+  std::unique_ptr<char, decltype(&free)> bounce(nullptr, &free);
+  if (!IsAligned(data, size)) {
+    assert(offset % DIRECT_IO_ALIGNMENT == 0);
+    target_size = (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    bounce.reset(static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, target_size)));
+    target = bounce.get();
+  }
+  size_t read_count = 0;
+  while (read_count < target_size) {
+    ssize_t rc = pread(db_fd_, target + read_count, target_size - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      throw Exception("I/O error while reading the db file at offset " + std::to_string(offset));
+    }
+    if (rc == 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  read_count = std::min(read_count, size);
+  if (target != data) {
+    memcpy(data, target, read_count);
+  }
+  return read_count;
+}
+
+}  // namespace bustub
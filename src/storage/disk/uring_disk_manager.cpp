@@ -0,0 +1,285 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// uring_disk_manager.cpp
+//
+// Identification: src/storage/disk/uring_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/uring_disk_manager.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+static int io_uring_setup(unsigned entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+/**
+ * Constructor: open the database file and set up the ring
+ */
+UringDiskManager::UringDiskManager(const std::string &db_file, bool direct_io) : PosixDiskManager(db_file, direct_io) {
+  SetUpRing();
+  if (IsUringEnabled()) {
+    reaper_thread_ = std::thread([this] { ReapCompletions(); });
+  }
+}
+
+UringDiskManager::~UringDiskManager() { ShutDown(); }
+
+void UringDiskManager::SetUpRing() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = io_uring_setup(RING_ENTRIES, &params);
+  if (ring_fd < 0) {
+    LOG_DEBUG("io_uring is not available, using the I/O thread pool");
+    return;
+  }
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ =
+      mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                                IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+    LOG_DEBUG("cannot map the io_uring rings, using the I/O thread pool");
+    if (sqes != MAP_FAILED) {
+      munmap(sqes, sqes_size_);
+    }
+    if (!single_mmap && cq_ring_ != MAP_FAILED) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    close(ring_fd);
+    return;
+  }
+  auto *sq_ring = static_cast<char *>(sq_ring_);
+  auto *cq_ring = static_cast<char *>(cq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.array);
+  sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+  cq_head_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+  entries_ = params.sq_entries;
+  ring_fd_ = ring_fd;
+}
+
+/**
+ * Wait for the requests in flight, stop the reaper and tear down the ring
+ */
+void UringDiskManager::ShutDown() {
+  if (IsUringEnabled()) {
+    {
+      std::unique_lock<std::mutex> lock(sq_latch_);
+      sq_cv_.wait(lock, [this] { return in_flight_ == 0; });
+    }
+    Submit(IORING_OP_NOP, INVALID_PAGE_ID, nullptr, false);
+    reaper_thread_.join();
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+  PosixDiskManager::ShutDown();
+}
+
+std::future<void> UringDiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  if (!IsUringEnabled()) {
+    return PosixDiskManager::WritePageAsync(page_id, page_data);
+  }
+  num_writes_ += 1;
+  // Stamp the checksum on an aligned copy, which the request owns until it completes.
+  auto *stamped = static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+  memcpy(stamped, page_data, CHECKSUM_OFFSET);
+  StampChecksum(stamped);
+  return Submit(IORING_OP_WRITEV, page_id, stamped, false);
+}
+
+std::future<void> UringDiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  if (!IsUringEnabled() || !IsAligned(page_data, PAGE_SIZE)) {
+    return PosixDiskManager::ReadPageAsync(page_id, page_data);
+  }
+  return Submit(IORING_OP_READV, page_id, page_data, true);
+}
+
+std::future<void> UringDiskManager::Submit(uint8_t opcode, page_id_t page_id, char *data, bool is_read) {
+  uring_request *request = nullptr;
+  std::future<void> future;
+  if (opcode != IORING_OP_NOP) {
+    request = new uring_request;
+    request->iov_.iov_base = data;
+    request->iov_.iov_len = PAGE_SIZE;
+    request->page_id_ = page_id;
+    request->is_read_ = is_read;
+    future = request->promise_.get_future();
+  }
+
+  std::unique_lock<std::mutex> lock(sq_latch_);
+  sq_cv_.wait(lock, [this] { return in_flight_ < entries_; });
+  // Only submitters write the tail, and they are serialized by sq_latch_.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  struct io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = db_fd_;
+  if (request != nullptr) {
+    sqe->off = GetPageOffset(page_id);
+    sqe->addr = reinterpret_cast<uintptr_t>(&request->iov_);
+    sqe->len = 1;
+  }
+  sqe->user_data = reinterpret_cast<uintptr_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  in_flight_ += 1;
+  unsigned pending = ++unsubmitted_;
+
+  // Whoever finds no submission in progress hands all queued entries to the kernel, including the ones queued by
+  // other threads in the meantime.
+  if (submitting_) {
+    return future;
+  }
+  submitting_ = true;
+  while (pending > 0) {
+    lock.unlock();
+    int rc = io_uring_enter(ring_fd_, pending, 0, 0);
+    lock.lock();
+    if (rc < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      LOG_DEBUG("io_uring_enter failed while submitting: %d", errno);
+      WithdrawUnsubmitted();
+      break;
+    }
+    unsubmitted_ -= rc;
+    pending = unsubmitted_;
+  }
+  submitting_ = false;
+  return future;
+}
+
+void UringDiskManager::WithdrawUnsubmitted() {
+  // The kernel has not seen the entries past the ones it consumed, and no other thread enters it while we hold the
+  // submission, so the tail can move back over them.
+  unsigned tail = *sq_tail_ - unsubmitted_;
+  for (unsigned i = 0; i < unsubmitted_; ++i) {
+    auto *request = reinterpret_cast<uring_request *>(sqes_[(tail + i) & *sq_mask_].user_data);
+    if (request == nullptr) {
+      continue;
+    }
+    if (!request->is_read_) {
+      free(request->iov_.iov_base);
+    }
+    request->promise_.set_exception(
+        std::make_exception_ptr(Exception("can't submit I/O request for page " + std::to_string(request->page_id_))));
+    delete request;
+  }
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+  in_flight_ -= unsubmitted_;
+  unsubmitted_ = 0;
+  sq_cv_.notify_all();
+}
+
+void UringDiskManager::ReapCompletions() {
+  bool stop = false;
+  while (!stop) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned reaped = 0;
+    for (; head != tail; ++head, ++reaped) {
+      struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      auto *request = reinterpret_cast<uring_request *>(cqe->user_data);
+      if (request == nullptr) {
+        stop = true;
+        continue;
+      }
+      auto done = cqe->res < 0 ? 0 : static_cast<size_t>(cqe->res);
+      auto *data = static_cast<char *>(request->iov_.iov_base);
+      if (!request->is_read_) {
+        free(data);
+        if (done < PAGE_SIZE) {
+          LOG_DEBUG("I/O error in asynchronous write: %d", cqe->res);
+          request->promise_.set_exception(
+              std::make_exception_ptr(Exception("I/O error while writing page " + std::to_string(request->page_id_))));
+        } else {
+          request->promise_.set_value();
+        }
+        delete request;
+        continue;
+      }
+      bool failed = cqe->res < 0;
+      if (!failed && done < PAGE_SIZE) {
+        // Only a file that ends before PAGE_SIZE reads short, the rest of the page is zeros then.
+        failed = static_cast<int64_t>(GetPageOffset(request->page_id_) + done) < GetFileSize(file_name_);
+        memset(data + done, 0, PAGE_SIZE - done);
+      }
+      if (failed) {
+        LOG_DEBUG("I/O error in asynchronous read: %d", cqe->res);
+        request->promise_.set_exception(
+            std::make_exception_ptr(Exception("I/O error while reading page " + std::to_string(request->page_id_))));
+        delete request;
+        continue;
+      }
+      if (VerifyChecksum(data)) {
+        memset(data + CHECKSUM_OFFSET, 0, PAGE_CHECKSUM_SIZE);
+        request->promise_.set_value();
+      } else {
+        request->promise_.set_exception(
+            std::make_exception_ptr(Exception("checksum mismatch on page " + std::to_string(request->page_id_))));
+      }
+      delete request;
+    }
+    if (reaped > 0) {
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      {
+        std::lock_guard<std::mutex> guard(sq_latch_);
+        in_flight_ -= reaped;
+      }
+      sq_cv_.notify_all();
+      continue;
+    }
+    if (io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      LOG_DEBUG("io_uring_enter failed while waiting for completions");
+    }
+  }
+}
+
+}  // namespace bustub
@@ -12,18 +12,26 @@
 
 #include "storage/page/hash_table_block_page.h"
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "storage/index/generic_key.h"
 
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BLOCK_TYPE::Clear() {
+  static_assert(sizeof(HashTableBlockPage) <= PAGE_SIZE - PAGE_CHECKSUM_SIZE, "block page does not fit in a page");
   for (auto iter = begin(occupied_); iter != end(occupied_); iter++) {
     *iter = 0;
   }
   for (auto iter = begin(readable_); iter != end(readable_); iter++) {
     *iter = 0;
   }
+  for (auto &tag : tags_) {
+    tag = EMPTY_TAG;
+  }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -48,7 +56,8 @@ ValueType HASH_TABLE_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) {
+bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value,
+                                   uint8_t tag) {
   auto byte_offset = bucket_ind / 8;
   auto bit_offset = bucket_ind % 8;
   char x = 1;
@@ -57,6 +66,7 @@ bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key,
     return false;
   }
   array_[bucket_ind] = std::make_pair(key, value);
+  tags_[bucket_ind] = tag;
   return true;
 }
 
@@ -87,6 +97,31 @@ bool HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const {
   return check_byte_bit(readable_[byte_offset], bit_offset);
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BLOCK_TYPE::MatchTag(slot_offset_t bucket_ind, uint8_t tag) const {
+  // The loads of a full group stay inside tags_, the last slots of the block are compared one by one.
+  if (bucket_ind + TAG_GROUP_SIZE > BLOCK_ARRAY_SIZE) {
+    uint32_t mask = 0;
+    for (slot_offset_t i = 0; bucket_ind + i < BLOCK_ARRAY_SIZE; i++) {
+      mask |= static_cast<uint32_t>(tags_[bucket_ind + i] == tag) << i;
+    }
+    return mask;
+  }
+#if defined(__AVX2__)
+  auto tags = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&tags_[bucket_ind]));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(tags, _mm256_set1_epi8(static_cast<char>(tag)))));
+#elif defined(__SSE2__)
+  auto tags = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&tags_[bucket_ind]));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+  uint32_t mask = 0;
+  for (slot_offset_t i = 0; i < TAG_GROUP_SIZE; i++) {
+    mask |= static_cast<uint32_t>(tags_[bucket_ind + i] == tag) << i;
+  }
+  return mask;
+#endif
+}
+
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
 template class HashTableBlockPage<int, int, IntComparator>;
 template class HashTableBlockPage<GenericKey<4>, RID, GenericComparator<4>>;
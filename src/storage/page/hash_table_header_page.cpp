@@ -13,6 +13,9 @@
 #include "storage/page/hash_table_header_page.h"
 
 namespace bustub {
+
+static_assert(sizeof(HashTableHeaderPage) <= PAGE_SIZE - PAGE_CHECKSUM_SIZE, "header page overlaps the checksum");
+
 page_id_t HashTableHeaderPage::GetBlockPageId(size_t index) { return block_page_ids_[index]; }
 
 page_id_t HashTableHeaderPage::GetPageId() const { return page_id_; }
@@ -27,8 +30,22 @@ void HashTableHeaderPage::AddBlockPageId(page_id_t page_id) { block_page_ids_[ne
 
 size_t HashTableHeaderPage::NumBlocks() { return next_ind_; }
 
+size_t HashTableHeaderPage::MaxNumBlocks() { return sizeof(block_page_ids_) / sizeof(page_id_t); }
+
 void HashTableHeaderPage::SetSize(size_t size) { size_ = size; }
 
 size_t HashTableHeaderPage::GetSize() const { return size_; }
 
+page_id_t HashTableHeaderPage::GetOldHeaderPageId() const { return old_header_page_id_; }
+
+void HashTableHeaderPage::SetOldHeaderPageId(page_id_t page_id) { old_header_page_id_ = page_id; }
+
+size_t HashTableHeaderPage::GetNumMigratedBlocks() const { return num_migrated_blocks_; }
+
+void HashTableHeaderPage::SetNumMigratedBlocks(size_t num_blocks) { num_migrated_blocks_ = num_blocks; }
+
+page_id_t HashTableHeaderPage::GetNextPageId() const { return next_page_id_; }
+
+void HashTableHeaderPage::SetNextPageId(page_id_t page_id) { next_page_id_ = page_id; }
+
 }  // namespace bustub
@@ -32,13 +32,13 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
   auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
   BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
   first_page->WLatch();
-  first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  first_page->Init(first_page_id_, PAGE_SIZE - PAGE_CHECKSUM_SIZE, INVALID_LSN, log_manager_, txn);
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
 bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+  if (tuple.size_ + 32 > PAGE_SIZE - PAGE_CHECKSUM_SIZE) {  // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
@@ -76,7 +76,7 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
       // Otherwise we were able to create a new page. We initialize it now.
       new_page->WLatch();
       cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
+      new_page->Init(next_page_id, PAGE_SIZE - PAGE_CHECKSUM_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
       cur_page = new_page;
@@ -177,11 +177,20 @@ TableIterator TableHeap::Begin(Transaction *txn) {
   RID rid;
   // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
   page->GetFirstTupleRid(&rid);
+  auto next_page_id = page->GetNextPageId();
   page->RUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, false);
+  ReadAhead(next_page_id);
   return TableIterator(this, rid, txn);
 }
 
+void TableHeap::ReadAhead(page_id_t page_id) {
+  if (page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->PrefetchPages(page_id, TABLE_SCAN_READ_AHEAD,
+                                        [](const char *page_data) { return TablePage::GetNextPageId(page_data); });
+  }
+}
+
 TableIterator TableHeap::End() { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
 
 }  // namespace bustub
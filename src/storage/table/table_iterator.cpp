@@ -48,6 +48,8 @@ TableIterator &TableIterator::operator++() {
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
+      // Keep the pages after the one we just moved to on their way into the buffer pool.
+      table_heap_->ReadAhead(cur_page->GetNextPageId());
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
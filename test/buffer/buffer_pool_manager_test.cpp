@@ -12,8 +12,14 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -139,4 +145,429 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ShardTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_shards = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, num_shards);
+  EXPECT_EQ(num_shards, bpm->GetNumShards());
+
+  // Scenario: we can create many more pages than frames as long as they are unpinned, and read all of them back.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 40; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the 10 frames are split 3/3/2/2. Once both frames of shard 3 are pinned, pages of that shard can no
+  // longer be fetched, while pages of the other shards still can.
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  ASSERT_NE(nullptr, bpm->FetchPage(7));
+  EXPECT_EQ(nullptr, bpm->FetchPage(11));
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  // Scenario: after unpinning one of them, the shard has room again.
+  EXPECT_EQ(true, bpm->UnpinPage(3, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(11));
+  EXPECT_EQ(0, strcmp(bpm->FetchPage(11)->GetData(), "page 11"));
+  EXPECT_EQ(true, bpm->UnpinPage(11, false));
+  EXPECT_EQ(true, bpm->UnpinPage(11, false));
+  EXPECT_EQ(true, bpm->UnpinPage(7, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 32;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Scenario: keep a few pages pinned so that fetches of them take the latch-free path, while fetches of the other
+  // pages keep evicting and reloading frames. Every fetch must see the content of the page it asked for.
+  for (page_id_t page_id : {0, 1}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([bpm, t] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      for (int i = 0; i < 2000; ++i) {
+        page_id_t page_id = i % 2 == 0 ? i % 4 / 2 : dist(gen);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (page_id_t page_id : {0, 1}) {
+    auto *page = bpm->FetchPage(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ArenaTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 1000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 4);
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: the frames are consecutive in one arena that starts on a huge page boundary.
+  auto *pages = bpm->GetPages();
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[0].GetData()) % (2 * 1024 * 1024));
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(pages[0].GetData() + i * PAGE_SIZE, pages[i].GetData());
+  }
+
+  // Scenario: new pages start zeroed even when their frame held another page before.
+  for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[PAGE_SIZE - 1]);
+    memset(page->GetData(), 'x', PAGE_SIZE);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  // The last bytes hold the checksum on disk and read back as zeros.
+  auto *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ('x', page->GetData()[PAGE_SIZE - PAGE_CHECKSUM_SIZE - 1]);
+  EXPECT_EQ(0, page->GetData()[PAGE_SIZE - 1]);
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, MmapViewTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 20;
+  {
+    DiskManager disk_manager(db_name);
+    BufferPoolManager bpm(num_pages, &disk_manager);
+    for (int i = 0; i < num_pages; ++i) {
+      page_id_t page_id;
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      bpm.UnpinPage(page_id, true);
+    }
+    EXPECT_TRUE(bpm.DeletePage(5));
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  MmapDiskManager disk_manager(db_name);
+  BufferPoolManager bpm(4, &disk_manager);
+  // Scenario: every page can be pinned at once, far more than the pool has frames, and the views point into the
+  // mapping without reading anything into the pool.
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    auto *page = bpm.FetchPage(page_id);
+    if (page_id == 5) {
+      EXPECT_EQ(nullptr, page);
+      continue;
+    }
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(disk_manager.GetPageData(page_id), page->GetData());
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, bpm.GetNumMisses());
+  EXPECT_EQ(nullptr, bpm.FetchPage(num_pages));
+  auto *page = bpm.FetchPage(0);
+  EXPECT_EQ(page, bpm.FetchPage(0));
+  EXPECT_EQ(3, page->GetPinCount());
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    EXPECT_EQ(page_id != 5, bpm.UnpinPage(page_id, false));
+  }
+  EXPECT_TRUE(bpm.UnpinPage(0, false));
+  EXPECT_TRUE(bpm.UnpinPage(0, false));
+  EXPECT_FALSE(bpm.UnpinPage(0, false));
+
+  // Scenario: the pool is read-only.
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm.NewPage(&page_id));
+  EXPECT_FALSE(bpm.DeletePage(0));
+  EXPECT_TRUE(bpm.FlushPage(0));
+
+  disk_manager.ShutDown();
+  remove("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2);
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Scenario: every frame is dirty, so the cleaner writes all of them back in the background.
+  bpm->RunPageCleaner(0.0);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->GetNumBackgroundWrites() < buffer_pool_size && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopPageCleaner();
+  EXPECT_EQ(buffer_pool_size, bpm->GetNumBackgroundWrites());
+
+  // Scenario: eviction now only finds clean victims and never writes in the foreground.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+  EXPECT_EQ(0, bpm->GetNumForegroundWrites());
+
+  // Scenario: the pages written by the cleaner can be read back.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 30;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  // Every page starts with the id of the next page in the chain, followed by some content. Page 9 ends the chain.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = page_id_temp != 9 ? page_id_temp + 1 : INVALID_PAGE_ID;
+    memcpy(page->GetData(), &next_page_id, sizeof(page_id_t));
+    snprintf(page->GetData() + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "page %d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  auto next_page_id = [](const char *page_data) { return *reinterpret_cast<const page_id_t *>(page_data); };
+
+  // Scenario: pages 0 to 4 have been evicted, the prefetch thread reads them back following the chain.
+  bpm->PrefetchPages(0, 5, next_page_id);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->GetNumPrefetchedPages() < 5 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(5, bpm->GetNumPrefetchedPages());
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData() + sizeof(page_id_t)));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: prefetching stops at the end of the chain.
+  bpm->PrefetchPages(8, 5, next_page_id);
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->GetNumPrefetchedPages() < 7 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(7, bpm->GetNumPrefetchedPages());
+
+  // Scenario: without a chain, a range of pages is read with all reads in flight at once.
+  bpm->PrefetchPages(10, 5);
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->GetNumPrefetchedPages() < 12 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(12, bpm->GetNumPrefetchedPages());
+  size_t num_misses = bpm->GetNumMisses();
+  for (page_id_t page_id = 10; page_id < 15; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData() + sizeof(page_id_t)));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_misses, bpm->GetNumMisses());
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// Measures the throughput of the hit path (fetch + unpin of resident pages) for a growing number of threads.
+// Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DISABLED_ConcurrentFetchBenchmark) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 1024;
+  const int ops_per_thread = 200000;
+
+  for (size_t num_shards : {1, 16}) {
+    for (size_t num_threads : {1, 2, 4, 8, 16, 32}) {
+      auto *disk_manager = new DiskManager(db_name);
+      auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, num_shards);
+      // Make every page resident so that the benchmark only exercises the hit path.
+      std::vector<page_id_t> page_ids(buffer_pool_size);
+      for (auto &page_id : page_ids) {
+        ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+        bpm->UnpinPage(page_id, false);
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+          std::mt19937 gen(t);
+          std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+          for (int i = 0; i < ops_per_thread; ++i) {
+            auto page_id = page_ids[dist(gen)];
+            bpm->FetchPage(page_id);
+            bpm->UnpinPage(page_id, false);
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "shards=" << num_shards << " threads=" << num_threads
+                << " fetch+unpin/s=" << static_cast<double>(num_threads * ops_per_thread) / elapsed.count()
+                << std::endl;
+
+      disk_manager->ShutDown();
+      remove("test.db");
+      delete bpm;
+      delete disk_manager;
+    }
+  }
+}
+
+// Mixes a sequential scan looping over a table that does not fit in the pool with skewed point lookups into a small hot
+// set, and reports the hit ratio of every replacement policy. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DISABLED_ScanResistanceBenchmark) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_hot_pages = 32;
+  const int num_scan_pages = 256;
+  const int num_rounds = 20;
+
+  for (auto policy : {ReplacerPolicy::CLOCK, ReplacerPolicy::LRU_K}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 1, policy);
+    // Pages [0, num_hot_pages) are the hot set, the following ones are scanned.
+    for (int i = 0; i < num_hot_pages + num_scan_pages; ++i) {
+      page_id_t page_id_temp;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+      bpm->UnpinPage(page_id_temp, false);
+    }
+    // Zipf-like skew: the i-th hot page is looked up with a probability proportional to 1 / (i + 1).
+    std::vector<double> weights;
+    for (int i = 0; i < num_hot_pages; ++i) {
+      weights.push_back(1.0 / (i + 1));
+    }
+    std::mt19937 gen(0);
+    std::discrete_distribution<page_id_t> hot_dist(weights.begin(), weights.end());
+
+    auto fetch = [bpm](page_id_t page_id) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    };
+    // Warm up the hot set before measuring.
+    for (int i = 0; i < 10 * num_hot_pages; ++i) {
+      fetch(hot_dist(gen));
+    }
+    size_t start_misses = bpm->GetNumMisses();
+    size_t num_fetches = 0;
+    size_t num_lookups = 0;
+    size_t lookup_misses = 0;
+    for (int round = 0; round < num_rounds; ++round) {
+      for (int i = 0; i < num_scan_pages; ++i) {
+        fetch(num_hot_pages + i);
+        // Two point lookups per scanned page.
+        for (int j = 0; j < 2; ++j) {
+          size_t misses = bpm->GetNumMisses();
+          fetch(hot_dist(gen));
+          lookup_misses += bpm->GetNumMisses() - misses;
+          num_lookups += 1;
+        }
+        num_fetches += 3;
+      }
+    }
+    size_t num_misses = bpm->GetNumMisses() - start_misses;
+    std::cout << "policy=" << (policy == ReplacerPolicy::CLOCK ? "clock" : "lru-k")
+              << " hit_ratio=" << 1.0 - static_cast<double>(num_misses) / static_cast<double>(num_fetches)
+              << " lookup_hit_ratio="
+              << 1.0 - static_cast<double>(lookup_misses) / static_cast<double>(num_lookups) << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
 }  // namespace bustub
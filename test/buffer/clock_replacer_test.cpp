@@ -12,7 +12,10 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <iostream>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -60,4 +63,73 @@ TEST(ClockReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrentPinUnpinTest) {
+  const size_t num_frames = 1000;
+  const int num_threads = 4;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: every thread owns a disjoint range of frames and keeps pinning and unpinning them, while the main thread
+  // takes victims and hands them back. Afterwards, every frame is in the replacer exactly once.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&clock_replacer, t] {
+      for (int round = 0; round < 100; ++round) {
+        for (size_t i = t; i < num_frames; i += num_threads) {
+          clock_replacer.Unpin(i);
+          clock_replacer.Pin(i);
+        }
+      }
+      for (size_t i = t; i < num_frames; i += num_threads) {
+        clock_replacer.Unpin(i);
+      }
+    });
+  }
+  int value;
+  for (int i = 0; i < 100; ++i) {
+    if (clock_replacer.Victim(&value)) {
+      EXPECT_LT(value, num_frames);
+      clock_replacer.Unpin(value);
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+  std::vector<bool> victimized(num_frames, false);
+  for (size_t i = 0; i < num_frames; ++i) {
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_FALSE(victimized[value]);
+    victimized[value] = true;
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
+// Measures the latency of Victim with one million frames, a growing fraction of which is pinned, while the frames
+// handed out are unpinned again as a buffer pool would. Run with --gtest_also_run_disabled_tests.
+TEST(ClockReplacerTest, DISABLED_VictimBenchmark) {
+  const size_t num_frames = 1000000;
+  const int num_victims = 1000000;
+
+  for (double pinned_ratio : {0.0, 0.5, 0.9, 0.99}) {
+    ClockReplacer clock_replacer(num_frames);
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> dist(0, 1);
+    for (size_t i = 0; i < num_frames; ++i) {
+      if (dist(gen) >= pinned_ratio) {
+        clock_replacer.Unpin(i);
+      }
+    }
+    int value;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_victims; ++i) {
+      clock_replacer.Victim(&value);
+      clock_replacer.Unpin(value);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "frames=" << num_frames << " pinned_ratio=" << pinned_ratio
+              << " ns/(victim+unpin)=" << elapsed.count() / num_victims << std::endl;
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <cstdio>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer. Each of them has been accessed once.
+  lru_replacer.Unpin(1);
+  lru_replacer.Unpin(2);
+  lru_replacer.Unpin(3);
+  lru_replacer.Unpin(4);
+  lru_replacer.Unpin(5);
+  lru_replacer.Unpin(6);
+  lru_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: access 1 a second time. It now has a finite backward 2-distance and is evicted after all the frames
+  // that have been accessed only once.
+  lru_replacer.Pin(1);
+  lru_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: get three victims. Frames accessed once go first, in the order of their access.
+  int value;
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: pin 5 and unpin it again, giving it a second access that is more recent than the ones of 1.
+  lru_replacer.Pin(5);
+  EXPECT_EQ(2, lru_replacer.Size());
+  lru_replacer.Unpin(5);
+
+  // Scenario: continue looking for victims. 6 was accessed once, then 1 has the oldest second most recent access.
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+
+  // Scenario: a removed frame is never victimized.
+  lru_replacer.Unpin(2);
+  lru_replacer.Remove(2);
+  EXPECT_EQ(0, lru_replacer.Size());
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util_test.cpp
+//
+// Identification: test/common/crc32c_util_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c_util.h"
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(Crc32cUtilTest, KnownValuesTest) {
+  std::string check("123456789");
+  EXPECT_EQ(0xe3069283, Crc32cUtil::Crc32cPortable(check.data(), check.size()));
+  EXPECT_EQ(0xe3069283, Crc32cUtil::Crc32c(check.data(), check.size()));
+  EXPECT_EQ(0, Crc32cUtil::Crc32c(check.data(), 0));
+
+  // 32 zero bytes, from RFC 3720.
+  char zeros[32] = {0};
+  EXPECT_EQ(0x8a9136aa, Crc32cUtil::Crc32c(zeros, sizeof(zeros)));
+
+  // A buffer can be checksummed in pieces.
+  uint32_t crc = Crc32cUtil::Crc32c(check.data(), 4);
+  EXPECT_EQ(0xe3069283, Crc32cUtil::Crc32c(check.data() + 4, check.size() - 4, crc));
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cUtilTest, HardwareMatchesPortableTest) {
+  if (!Crc32cUtil::HasHardwareSupport()) {
+    GTEST_SKIP();
+  }
+  std::mt19937 gen(42);
+  std::vector<char> data(4 * PAGE_SIZE);
+  for (auto &c : data) {
+    c = static_cast<char>(gen());
+  }
+  // Every alignment and sizes around the three stream blocks of the hardware implementation.
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t size : {0, 1, 7, 8, 255, 767, 768, 769, 1536, 4092, 4096, 3 * PAGE_SIZE}) {
+      EXPECT_EQ(Crc32cUtil::Crc32cPortable(data.data() + offset, size),
+                Crc32cUtil::Crc32cHardware(data.data() + offset, size))
+          << "offset " << offset << " size " << size;
+    }
+  }
+}
+
+// Measures the time to checksum a page with each implementation. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(Crc32cUtilTest, DISABLED_PageChecksumBenchmark) {
+  const int iterations = 1000000;
+  std::vector<char> page(PAGE_SIZE, 'a');
+  auto measure = [&](uint32_t (*crc32c)(const char *, size_t, uint32_t)) {
+    uint32_t crc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      crc = crc32c(page.data(), PAGE_SIZE - PAGE_CHECKSUM_SIZE, crc);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_NE(0, crc);
+    return elapsed.count() / iterations;
+  };
+  std::cout << "portable: " << measure(&Crc32cUtil::Crc32cPortable) << " ns/page" << std::endl;
+  if (Crc32cUtil::HasHardwareSupport()) {
+    std::cout << "sse4.2:   " << measure(&Crc32cUtil::Crc32cHardware) << " ns/page" << std::endl;
+  }
+}
+
+}  // namespace bustub
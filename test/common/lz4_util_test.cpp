@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_util_test.cpp
+//
+// Identification: test/common/lz4_util_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz4_util.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Compresses and decompresses a buffer, returns the compressed size.
+static size_t RoundTrip(const std::vector<char> &data) {
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  size_t size = Lz4Util::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  EXPECT_NE(0, size);
+  std::vector<char> decompressed(data.size());
+  EXPECT_TRUE(Lz4Util::Decompress(compressed.data(), size, decompressed.data(), decompressed.size()));
+  EXPECT_EQ(data, decompressed);
+  return size;
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4UtilTest, RoundTripTest) {
+  std::mt19937 gen(42);
+  // Short buffers are stored as literals only.
+  for (size_t size = 0; size < 32; size++) {
+    RoundTrip(std::vector<char>(size, 'a'));
+  }
+
+  // A page of low cardinality integers, with runs of equal values, compresses well.
+  std::vector<char> page(PAGE_SIZE);
+  int32_t value = 0;
+  for (size_t i = 0; i < PAGE_SIZE / sizeof(int32_t); i++) {
+    if (i % 8 == 0) {
+      value = static_cast<int32_t>(gen() % 4);
+    }
+    memcpy(page.data() + i * sizeof(int32_t), &value, sizeof(value));
+  }
+  EXPECT_LT(RoundTrip(page), PAGE_SIZE / 2);
+
+  // Long runs need a length continuation byte per 255 bytes.
+  EXPECT_LT(RoundTrip(std::vector<char>(PAGE_SIZE, 0)), 64 + PAGE_SIZE / 255);
+
+  // Random data does not compress, but still round trips.
+  for (auto &c : page) {
+    c = static_cast<char>(gen());
+  }
+  EXPECT_GE(RoundTrip(page), PAGE_SIZE);
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4UtilTest, MalformedInputTest) {
+  std::vector<char> page(PAGE_SIZE, 'x');
+  std::vector<char> compressed(PAGE_SIZE);
+  size_t size = Lz4Util::Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0, size);
+  std::vector<char> out(PAGE_SIZE);
+
+  // The output buffer has to be large enough.
+  EXPECT_EQ(0, Lz4Util::Compress(page.data(), page.size(), compressed.data(), 4));
+  // Truncated input, and input that decompresses to another size, are rejected.
+  EXPECT_FALSE(Lz4Util::Decompress(compressed.data(), size - 1, out.data(), out.size()));
+  EXPECT_FALSE(Lz4Util::Decompress(compressed.data(), size, out.data(), out.size() - 1));
+  EXPECT_FALSE(Lz4Util::Decompress(compressed.data(), 0, out.data(), out.size()));
+  // A match reaching before the start of the output is rejected.
+  char bad_offset[] = {0x10, 'a', 0x10, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+  EXPECT_FALSE(Lz4Util::Decompress(bad_offset, sizeof(bad_offset), out.data(), 10));
+}
+
+}  // namespace bustub
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varint_util_test.cpp
+//
+// Identification: test/common/varint_util_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/varint_util.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(VarintUtilTest, RoundTripTest) {
+  std::vector<uint64_t> values{0, 1, 127, 128, 255, 300, 16383, 16384, UINT32_MAX, uint64_t{1} << 63, UINT64_MAX};
+  std::mt19937_64 gen(42);
+  for (int i = 0; i < 1000; i++) {
+    // Spread the values over all sizes.
+    values.push_back(gen() >> (gen() % 64));
+  }
+  char data[VarintUtil::MAX_SIZE];
+  for (uint64_t value : values) {
+    size_t size = VarintUtil::Encode(value, data);
+    EXPECT_EQ(VarintUtil::Size(value), size);
+    uint64_t decoded = 0;
+    EXPECT_EQ(size, VarintUtil::Decode(data, sizeof(data), &decoded));
+    EXPECT_EQ(value, decoded);
+  }
+  EXPECT_EQ(1, VarintUtil::Size(127));
+  EXPECT_EQ(2, VarintUtil::Size(128));
+  EXPECT_EQ(5, VarintUtil::Size(UINT32_MAX));
+  EXPECT_EQ(VarintUtil::MAX_SIZE, VarintUtil::Size(UINT64_MAX));
+}
+
+// NOLINTNEXTLINE
+TEST(VarintUtilTest, MalformedTest) {
+  char data[VarintUtil::MAX_SIZE + 1];
+  uint64_t value;
+  // Cut by the end of the buffer.
+  size_t size = VarintUtil::Encode(uint64_t{1} << 40, data);
+  for (size_t available = 0; available < size; available++) {
+    EXPECT_EQ(0, VarintUtil::Decode(data, available, &value));
+  }
+  // More than 64 bits.
+  for (auto &byte : data) {
+    byte = static_cast<char>(0x81);
+  }
+  data[VarintUtil::MAX_SIZE - 1] = 0x02;
+  EXPECT_EQ(0, VarintUtil::Decode(data, sizeof(data), &value));
+  data[VarintUtil::MAX_SIZE - 1] = static_cast<char>(0x81);
+  EXPECT_EQ(0, VarintUtil::Decode(data, sizeof(data), &value));
+}
+
+}  // namespace bustub
@@ -0,0 +1,228 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_test.cpp
+//
+// Identification: test/container/extendible_hash_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catalog/schema.h"
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // insert a few values, and one more value for each key
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i + 1));
+  }
+  for (int i = 0; i < 5; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(2, res.size());
+    EXPECT_EQ(i + 2 * i + 1, res[0] + res[1]);
+  }
+
+  // look for a key that does not exist
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 20, &res));
+
+  // delete the values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(2 * i + 1, res[0]);
+    EXPECT_TRUE(ht.Remove(nullptr, i, 2 * i + 1));
+    EXPECT_FALSE(ht.GetValue(nullptr, i, &res));
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, SplitMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // The buckets split and the directory grows, the entries are found in the buckets they moved to.
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_LT(0, ht.GetGlobalDepth());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // The emptied buckets merge and the directory shrinks back to a single bucket.
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, i, &res));
+  }
+  for (int i = 1; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, OverflowTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> ht(
+      "blah", bpm, GenericComparator<64>(&key_schema), HashFunction<GenericKey<64>>());
+
+  // The values of a single key fill many bucket pages, which cannot be split and overflow instead.
+  const int num_values = 1000;
+  GenericKey<64> key;
+  key.SetFromInteger(0);
+  for (int i = 0; i < num_values; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, key, RID(i, i))) << "Failed to insert " << i;
+    EXPECT_FALSE(ht.Insert(nullptr, key, RID(i, i)));
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  // The other keys split the bucket, the values of the key move together.
+  const int num_keys = 500;
+  for (int i = 1; i < num_keys; i++) {
+    key.SetFromInteger(i);
+    EXPECT_TRUE(ht.Insert(nullptr, key, RID(i, i)));
+  }
+  EXPECT_LT(0, ht.GetGlobalDepth());
+  std::vector<RID> res;
+  key.SetFromInteger(0);
+  EXPECT_TRUE(ht.GetValue(nullptr, key, &res));
+  EXPECT_EQ(num_values, res.size());
+  for (int i = 1; i < num_keys; i++) {
+    res.clear();
+    key.SetFromInteger(i);
+    EXPECT_TRUE(ht.GetValue(nullptr, key, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(RID(i, i), res[0]);
+  }
+
+  // The emptied overflow pages are deleted and the buckets merge back to a single one.
+  key.SetFromInteger(0);
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, key, RID(i, i)));
+  }
+  res.clear();
+  EXPECT_FALSE(ht.GetValue(nullptr, key, &res));
+  for (int i = 1; i < num_keys; i++) {
+    key.SetFromInteger(i);
+    EXPECT_TRUE(ht.Remove(nullptr, key, RID(i, i)));
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(256, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Writers insert disjoint keys while the buckets split, readers look up and remove the keys inserted before.
+  const int num_threads = 4;
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, -i - 1, i));
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_keys; i += num_threads) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+      }
+    });
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_keys; i += num_threads) {
+        std::vector<int> res;
+        EXPECT_TRUE(ht.GetValue(nullptr, -i - 1, &res));
+        EXPECT_EQ(1, res.size());
+        EXPECT_TRUE(ht.Remove(nullptr, -i - 1, i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+    EXPECT_FALSE(ht.GetValue(nullptr, -i - 1, &res));
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, OpenTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t directory_page_id;
+  const int num_keys = 2000;
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+    for (int i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    directory_page_id = ht.GetDirectoryPageId();
+  }
+
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(),
+                                                  directory_page_id);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
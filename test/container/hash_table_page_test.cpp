@@ -18,6 +18,8 @@
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/hash_table_block_page.h"
+#include "storage/page/hash_table_bucket_page.h"
+#include "storage/page/hash_table_directory_page.h"
 #include "storage/page/hash_table_header_page.h"
 
 namespace bustub {
@@ -73,7 +75,7 @@ TEST(HashTablePageTest, BlockPageSampleTest) {
 
   // insert a few (key, value) pairs
   for (unsigned i = 0; i < 10; i++) {
-    block_page->Insert(i, i, i);
+    block_page->Insert(i, i, i, 0x80 | i);
   }
 
   // check for the inserted pairs
@@ -103,6 +105,22 @@ TEST(HashTablePageTest, BlockPageSampleTest) {
     }
   }
 
+  // check for the tags, removed pairs keep theirs
+  using BlockPage = HashTableBlockPage<int, int, IntComparator>;
+  for (unsigned i = 0; i < 10; i++) {
+    EXPECT_EQ(1U << i, block_page->MatchTag(0, 0x80 | i));
+  }
+  EXPECT_EQ(0, block_page->MatchTag(0, 0x8a));
+  auto group_mask = BlockPage::TAG_GROUP_SIZE == 32 ? UINT32_MAX : (1U << BlockPage::TAG_GROUP_SIZE) - 1;
+  EXPECT_EQ(group_mask & ~0x3ffU, block_page->MatchTag(0, BlockPage::EMPTY_TAG));
+  EXPECT_EQ(group_mask & ~0x1fU, block_page->MatchTag(5, BlockPage::EMPTY_TAG));
+
+  // the last slots of the block are compared up to its end
+  auto last_index = block_page->SlotsNum() - 3;
+  EXPECT_EQ(0x7U, block_page->MatchTag(last_index, BlockPage::EMPTY_TAG));
+  block_page->Insert(last_index + 1, 1, 1, 0x81);
+  EXPECT_EQ(0x2U, block_page->MatchTag(last_index, 0x81));
+
   // unpin the header page now that we are done
   bpm->UnpinPage(block_page_id, true, nullptr);
   disk_manager->ShutDown();
@@ -111,4 +129,96 @@ TEST(HashTablePageTest, BlockPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+
+  // get a directory page from the BufferPoolManager
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  auto directory_page =
+      reinterpret_cast<HashTableDirectoryPage *>(bpm->NewPage(&directory_page_id, nullptr)->GetData());
+  EXPECT_EQ(0, directory_page->GetGlobalDepth());
+  EXPECT_EQ(1, directory_page->Size());
+  directory_page->SetBucketPageId(0, 10);
+
+  // doubling the directory copies the entries to its upper half
+  directory_page->IncrGlobalDepth();
+  EXPECT_EQ(2, directory_page->Size());
+  EXPECT_EQ(0x1, directory_page->GetGlobalDepthMask());
+  EXPECT_EQ(10, directory_page->GetBucketPageId(1));
+  EXPECT_EQ(0, directory_page->GetLocalDepth(1));
+  EXPECT_TRUE(directory_page->CanShrink());
+
+  // split the bucket
+  directory_page->SetBucketPageId(1, 11);
+  directory_page->SetLocalDepth(0, 1);
+  directory_page->SetLocalDepth(1, 1);
+  EXPECT_EQ(1, directory_page->GetSplitImageIndex(0));
+  EXPECT_EQ(0, directory_page->GetSplitImageIndex(1));
+  EXPECT_FALSE(directory_page->CanShrink());
+
+  directory_page->IncrGlobalDepth();
+  EXPECT_EQ(4, directory_page->Size());
+  EXPECT_EQ(11, directory_page->GetBucketPageId(3));
+  EXPECT_EQ(0x1, directory_page->GetLocalDepthMask(3));
+  EXPECT_TRUE(directory_page->CanShrink());
+  directory_page->DecrGlobalDepth();
+  EXPECT_EQ(2, directory_page->Size());
+
+  // unpin the directory page now that we are done
+  bpm->UnpinPage(directory_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageSampleTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+
+  // get a bucket page from the BufferPoolManager
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page = reinterpret_cast<HashTableBucketPage<int, int, IntComparator> *>(
+      bpm->NewPage(&bucket_page_id, nullptr)->GetData());
+  bucket_page->Clear();
+  EXPECT_TRUE(bucket_page->IsEmpty());
+  EXPECT_EQ(INVALID_PAGE_ID, bucket_page->GetNextPageId());
+
+  // insert a few (key, value) pairs, duplicate pairs are rejected
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(bucket_page->Insert(i, i, IntComparator()));
+    EXPECT_FALSE(bucket_page->Insert(i, i, IntComparator()));
+  }
+  EXPECT_EQ(10, bucket_page->NumReadable());
+
+  // remove a few pairs, their slots are reused
+  for (int i = 0; i < 10; i += 2) {
+    EXPECT_TRUE(bucket_page->Remove(i, i, IntComparator()));
+    EXPECT_FALSE(bucket_page->IsReadable(i));
+  }
+  EXPECT_TRUE(bucket_page->Insert(1, 2, IntComparator()));
+  EXPECT_TRUE(bucket_page->IsReadable(0));
+  std::vector<int> res;
+  EXPECT_TRUE(bucket_page->GetValue(1, IntComparator(), &res));
+  EXPECT_EQ(2, res.size());
+  EXPECT_FALSE(bucket_page->GetValue(0, IntComparator(), &res));
+
+  // fill the bucket
+  for (int i = 10; !bucket_page->IsFull(); i++) {
+    EXPECT_TRUE(bucket_page->Insert(i, i, IntComparator()));
+  }
+  EXPECT_EQ(bucket_page->SlotsNum(), bucket_page->NumReadable());
+  EXPECT_FALSE(bucket_page->Insert(-1, -1, IntComparator()));
+
+  // unpin the bucket page now that we are done
+  bpm->UnpinPage(bucket_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -10,13 +10,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <iostream>
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "catalog/schema.h"
 #include "common/logger.h"
 #include "container/hash/linear_probe_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "storage/disk/mmap_disk_manager.h"
+#include "storage/index/generic_key.h"
 
 namespace bustub {
 
@@ -108,4 +115,307 @@ TEST(HashTableTest, SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(256, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  size_t initial_size = ht.GetSize();
+
+  // The table grows several times, the lookups and removes in between find the entries in either block array.
+  const int num_keys = 20 * static_cast<int>(initial_size);
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_FALSE(ht.Insert(nullptr, i / 2, i / 2));
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i / 3, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i / 3;
+    if (i % 5 == 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i / 5, i / 5));
+      EXPECT_TRUE(ht.Insert(nullptr, i / 5, i / 5));
+    }
+  }
+  EXPECT_LE(16 * initial_size, ht.GetSize());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, i, &res));
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentGrowTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(256, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+
+  // Writers insert disjoint keys while the table grows, readers look up the keys inserted before.
+  const int num_threads = 4;
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, -i - 1, i));
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_keys; i += num_threads) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+      }
+    });
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_keys; i += num_threads) {
+        std::vector<int> res;
+        EXPECT_TRUE(ht.GetValue(nullptr, -i - 1, &res));
+        EXPECT_EQ(1, res.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, OpenGrowingTableTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(256, disk_manager);
+  page_id_t header_page_id;
+  const int num_keys = 1000;
+  {
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2 * num_keys, HashFunction<int>());
+    for (int i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    // Start growing, the entries stay in the old block array until the next inserts and removes move them.
+    ht.Resize(ht.GetSize());
+    header_page_id = ht.GetHeaderPageId();
+  }
+
+  // The opened table reads the block directories of both block arrays from the header pages.
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), header_page_id);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+  }
+  for (int i = num_keys; i < 4 * num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_FALSE(ht.Insert(nullptr, i - num_keys, i - num_keys));
+  }
+  for (int i = 0; i < 4 * num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ManyBlocksTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(256, disk_manager);
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  GenericComparator<64> comparator(&key_schema);
+  page_id_t header_page_id;
+  // Large keys need more block page ids than a header page holds, the block directory continues in more pages.
+  const int num_keys = 60000;
+  GenericKey<64> key;
+  {
+    LinearProbeHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator, 1000,
+                                                                        HashFunction<GenericKey<64>>());
+    for (int i = 0; i < num_keys; i++) {
+      key.SetFromInteger(i);
+      ASSERT_TRUE(ht.Insert(nullptr, key, RID(i, i))) << "Failed to insert " << i;
+    }
+    header_page_id = ht.GetHeaderPageId();
+    auto *hp = reinterpret_cast<HashTableHeaderPage *>(bpm->FetchPage(header_page_id)->GetData());
+    EXPECT_EQ(HashTableHeaderPage::MaxNumBlocks(), hp->NumBlocks());
+    EXPECT_NE(INVALID_PAGE_ID, hp->GetNextPageId());
+    bpm->UnpinPage(header_page_id, false);
+  }
+
+  LinearProbeHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator,
+                                                                      HashFunction<GenericKey<64>>(), header_page_id);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<RID> res;
+    key.SetFromInteger(i);
+    EXPECT_TRUE(ht.GetValue(nullptr, key, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(RID(i, i), res[0]);
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MmapSnapshotTest) {
+  page_id_t header_page_id;
+  {
+    DiskManager disk_manager("test.db");
+    BufferPoolManager bpm(50, &disk_manager);
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), 1000, HashFunction<int>());
+    for (int i = 0; i < 500; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
+    }
+    header_page_id = ht.GetHeaderPageId();
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  // Look the values up in the pages of the mapped file.
+  MmapDiskManager disk_manager("test.db");
+  BufferPoolManager bpm(4, &disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), HashFunction<int>(), header_page_id);
+  for (int i = 0; i < 500; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(2 * i, res[0]);
+  }
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 500, &res));
+  EXPECT_EQ(0, bpm.GetNumMisses());
+  disk_manager.ShutDown();
+  remove("test.db");
+}
+
+// Measures the latency of inserts while the table grows from 1000 buckets. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_InsertLatencyBenchmark) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(4096, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  const int num_keys = 250000;
+  std::vector<int64_t> latencies;
+  latencies.reserve(num_keys);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_keys; i++) {
+    auto insert_start = std::chrono::steady_clock::now();
+    ht.Insert(nullptr, i, i);
+    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                             insert_start)
+                            .count());
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << num_keys / elapsed << " inserts/s, latency p50 " << latencies[num_keys / 2] << " ns, p99 "
+            << latencies[num_keys * 99 / 100] << " ns, p99.9 " << latencies[num_keys * 999 / 1000] << " ns, max "
+            << latencies.back() << " ns, final size " << ht.GetSize() << std::endl;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Measures the throughput of concurrent inserts and then lookups of disjoint keys, at 1 to 64 threads. The table does
+// not grow. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_ConcurrentThroughputBenchmark) {
+  const int num_keys = 200000;
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManager(4096, disk_manager);
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2 * num_keys, HashFunction<int>());
+
+    auto run = [num_threads](const std::function<void(int)> &op) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&op, num_threads, t] {
+          for (int i = t; i < num_keys; i += num_threads) {
+            op(i);
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      return num_keys / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto inserts = run([&ht](int i) { EXPECT_TRUE(ht.Insert(nullptr, i, i)); });
+    auto lookups = run([&ht](int i) {
+      std::vector<int> res;
+      EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    });
+    std::cout << num_threads << " threads: " << inserts << " inserts/s, " << lookups << " lookups/s" << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+    delete bpm;
+  }
+}
+
+// Looks up present and absent keys of a table of GenericKey<KeySize> keys, compared on a BIGINT column.
+template <size_t KeySize>
+void GenericKeyLookupBenchmark() {
+  const int num_keys = 100000;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(4096, disk_manager);
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  LinearProbeHashTable<GenericKey<KeySize>, RID, GenericComparator<KeySize>> ht(
+      "blah", bpm, GenericComparator<KeySize>(&key_schema), num_keys, HashFunction<GenericKey<KeySize>>());
+
+  GenericKey<KeySize> key;
+  for (int i = 0; i < num_keys; i++) {
+    key.SetFromInteger(i);
+    ht.Insert(nullptr, key, RID(i, i));
+  }
+  auto run = [&ht, &key](int first_key) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = first_key; i < first_key + num_keys; i++) {
+      std::vector<RID> res;
+      key.SetFromInteger(i);
+      ht.GetValue(nullptr, key, &res);
+    }
+    return num_keys / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+  auto hits = run(0);
+  auto misses = run(num_keys);
+  std::cout << "GenericKey<" << KeySize << ">: " << hits << " hits/s, " << misses << " misses/s" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_GenericKeyLookupBenchmark) {
+  GenericKeyLookupBenchmark<8>();
+  GenericKeyLookupBenchmark<16>();
+  GenericKeyLookupBenchmark<32>();
+  GenericKeyLookupBenchmark<64>();
+}
+
 }  // namespace bustub
@@ -0,0 +1,287 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_manager.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, AppendFlushTest) {
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+  DiskManager disk_manager("test.db");
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+  EXPECT_TRUE(enable_logging);
+
+  // Fill the log buffer several times over, appends wait for the flush thread to make room.
+  lsn_t last_lsn = INVALID_LSN;
+  for (int i = 0, appended = 0; appended < 3 * LOG_BUFFER_SIZE; i++) {
+    LogRecord log_record(i, last_lsn, LogRecordType::BEGIN);
+    appended += log_record.GetSize();
+    lsn_t next_lsn = log_manager.AppendLogRecord(&log_record);
+    // The lsn of a record that did not fit in a full buffer is skipped.
+    EXPECT_GT(next_lsn, last_lsn);
+    EXPECT_EQ(next_lsn, log_record.GetLSN());
+    last_lsn = next_lsn;
+  }
+  EXPECT_GT(disk_manager.GetNumFlushes(), 1);
+  // Flush does not wait for the timeout.
+  auto start = std::chrono::steady_clock::now();
+  log_manager.Flush(last_lsn);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, log_timeout);
+  EXPECT_EQ(last_lsn, log_manager.GetPersistentLSN());
+  // Records that were not appended are not waited for.
+  log_manager.Flush(last_lsn + 100);
+
+  // The first write is a frame of uncompressed records.
+  std::vector<char> frame(LogManager::MAX_FRAME_SIZE);
+  ASSERT_TRUE(disk_manager.ReadLog(frame.data(), LogManager::FRAME_HEADER_SIZE, 0));
+  size_t frame_size = LogManager::GetFrameSize(frame.data());
+  ASSERT_NE(0, frame_size);
+  ASSERT_TRUE(disk_manager.ReadLog(frame.data(), frame_size, 0));
+  size_t records_size;
+  const char *records = LogManager::GetFrameRecords(frame.data(), nullptr, &records_size);
+  ASSERT_NE(nullptr, records);
+  EXPECT_EQ(frame_size, LogManager::FRAME_HEADER_SIZE + records_size);
+  size_t pos = 0;
+  for (lsn_t lsn = 0; lsn <= 7; lsn++) {
+    LogRecord log_record;
+    ASSERT_TRUE(log_record.DeserializeFrom(records + pos, records_size - pos));
+    EXPECT_EQ(lsn, log_record.GetLSN());
+    EXPECT_EQ(lsn, log_record.GetTxnId());
+    EXPECT_EQ(LogRecordType::BEGIN, log_record.GetLogRecordType());
+    pos += log_record.GetSize();
+  }
+  // A corrupt frame is rejected.
+  frame[frame_size - 1] ^= 1;
+  EXPECT_EQ(nullptr, LogManager::GetFrameRecords(frame.data(), nullptr, &records_size));
+
+  log_manager.StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  disk_manager.ShutDown();
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, GroupCommitTest) {
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+  DiskManager disk_manager("test.db");
+  LogManager log_manager(&disk_manager);
+  LockManager lock_manager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  TransactionManager transaction_manager(&lock_manager, &log_manager);
+  // A long timeout: commits must not wait for it.
+  auto old_log_timeout = log_timeout;
+  log_timeout = std::chrono::seconds(10);
+  log_manager.RunFlushThread();
+
+  const int num_threads = 8;
+  const int num_commits = 50;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < num_commits; j++) {
+        auto *txn = transaction_manager.Begin();
+        transaction_manager.Commit(txn);
+        // The commit record is persistent once Commit returns.
+        EXPECT_LE(txn->GetPrevLSN(), log_manager.GetPersistentLSN());
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(2 * num_threads * num_commits, log_manager.GetNextLSN());
+  EXPECT_LE(disk_manager.GetNumFlushes(), num_threads * num_commits);
+
+  log_manager.StopFlushThread();
+  log_timeout = old_log_timeout;
+  disk_manager.ShutDown();
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// Measures commit throughput with a varying number of concurrent committers, and how many commits share a log write.
+// Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(LogManagerTest, DISABLED_GroupCommitBenchmark) {
+  const auto duration = std::chrono::seconds(1);
+  for (int num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+    remove("test.db");
+    DiskManager::RemoveLogFiles("test.db");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    LockManager lock_manager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+    TransactionManager transaction_manager(&lock_manager, &log_manager);
+    log_manager.RunFlushThread();
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> num_commits{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&] {
+        while (!stop) {
+          auto *txn = transaction_manager.Begin();
+          transaction_manager.Commit(txn);
+          delete txn;
+          num_commits += 1;
+        }
+      });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    log_manager.StopFlushThread();
+    std::cout << num_threads << " committers: " << num_commits / std::chrono::duration<double>(duration).count()
+              << " commits/s, " << static_cast<double>(num_commits) / disk_manager.GetNumFlushes()
+              << " commits per log write" << std::endl;
+    disk_manager.ShutDown();
+  }
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// Measures append throughput of insert records with a varying number of threads. Run with
+// --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(LogManagerTest, DISABLED_AppendBenchmark) {
+  const auto duration = std::chrono::seconds(1);
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 100}}};
+  const Tuple tuple({Value(TypeId::INTEGER, 0), Value(TypeId::VARCHAR, std::string(100, 'a'))}, &schema);
+  for (int num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+    remove("test.db");
+    DiskManager::RemoveLogFiles("test.db");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    log_manager.RunFlushThread();
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> num_appends{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&, i] {
+        size_t count = 0;
+        while (!stop) {
+          LogRecord log_record(i, INVALID_LSN, LogRecordType::INSERT, RID(i, 0), tuple);
+          log_manager.AppendLogRecord(&log_record);
+          count++;
+        }
+        num_appends += count;
+      });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    log_manager.StopFlushThread();
+    std::cout << num_threads << " threads: " << num_appends / std::chrono::duration<double>(duration).count()
+              << " appends/s" << std::endl;
+    disk_manager.ShutDown();
+  }
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// Measures the bytes of log written per transaction for transactions that insert tuples, and for transactions that
+// update two columns of tuples, with and without compression. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(LogManagerTest, DISABLED_LogSizeBenchmark) {
+  const int num_tuples = 1000;
+  const int num_txns = 2000;
+  const int ops_per_txn = 4;
+  Schema schema{{Column{"id", TypeId::INTEGER}, Column{"balance", TypeId::BIGINT}, Column{"count", TypeId::INTEGER},
+                 Column{"name", TypeId::VARCHAR, 32}, Column{"comment", TypeId::VARCHAR, 64}}};
+  auto make_tuple = [&schema](int id, int64_t balance, int count) {
+    return Tuple({Value(TypeId::INTEGER, id), Value(TypeId::BIGINT, balance), Value(TypeId::INTEGER, count),
+                  Value(TypeId::VARCHAR, "customer#" + std::to_string(id)),
+                  Value(TypeId::VARCHAR, "a regular customer since " + std::to_string(1990 + id % 30))},
+                 &schema);
+  };
+  for (bool compress : {false, true}) {
+    remove("test.db");
+    DiskManager::RemoveLogFiles("test.db");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager, compress);
+    BufferPoolManager bpm(256, &disk_manager, &log_manager);
+    LockManager lock_manager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+    TransactionManager transaction_manager(&lock_manager, &log_manager);
+    log_manager.RunFlushThread();
+    std::mt19937 generator(42);
+
+    auto *txn = transaction_manager.Begin();
+    TableHeap table(&bpm, &lock_manager, &log_manager, txn);
+    transaction_manager.Commit(txn);
+    delete txn;
+    std::vector<RID> rids;
+    size_t start = disk_manager.GetLogOffset();
+    for (int i = 0; i < num_tuples / ops_per_txn; i++) {
+      txn = transaction_manager.Begin();
+      for (int j = 0; j < ops_per_txn; j++) {
+        int id = i * ops_per_txn + j;
+        RID rid;
+        ASSERT_TRUE(table.InsertTuple(make_tuple(id, generator() % 100000, 0), &rid, txn));
+        rids.push_back(rid);
+      }
+      transaction_manager.Commit(txn);
+      delete txn;
+    }
+    const char *mode = compress ? "compressed " : "";
+    std::cout << mode << "insert: "
+              << static_cast<double>(disk_manager.GetLogOffset() - start) / (num_tuples / ops_per_txn) << " bytes/txn"
+              << std::endl;
+
+    start = disk_manager.GetLogOffset();
+    for (int i = 0; i < num_txns; i++) {
+      txn = transaction_manager.Begin();
+      for (int j = 0; j < ops_per_txn; j++) {
+        int id = generator() % num_tuples;
+        Tuple tuple;
+        ASSERT_TRUE(table.GetTuple(rids[id], &tuple, txn));
+        int64_t balance = tuple.GetValue(&schema, 1).GetAs<int64_t>() + generator() % 1000;
+        int count = tuple.GetValue(&schema, 2).GetAs<int32_t>() + 1;
+        ASSERT_TRUE(table.UpdateTuple(make_tuple(id, balance, count), rids[id], txn));
+      }
+      transaction_manager.Commit(txn);
+      delete txn;
+    }
+    std::cout << mode << "update: " << static_cast<double>(disk_manager.GetLogOffset() - start) / num_txns
+              << " bytes/txn" << std::endl;
+    log_manager.StopFlushThread();
+    disk_manager.ShutDown();
+  }
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+}  // namespace bustub
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_record_test.cpp
+//
+// Identification: test/recovery/log_record_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_record.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Serializes a record and deserializes it back.
+static LogRecord RoundTrip(LogRecord log_record) {
+  std::vector<char> data(log_record.GetSize());
+  log_record.SerializeTo(data.data());
+  LogRecord result;
+  EXPECT_TRUE(result.DeserializeFrom(data.data(), data.size()));
+  EXPECT_EQ(static_cast<int32_t>(data.size()), result.GetSize());
+  // Every prefix of the record is rejected.
+  for (size_t size = 0; size < data.size(); size++) {
+    LogRecord cut;
+    EXPECT_FALSE(cut.DeserializeFrom(data.data(), size));
+  }
+  return result;
+}
+
+static bool SameTuple(const Tuple &a, const Tuple &b) {
+  return a.GetLength() == b.GetLength() && memcmp(a.GetData(), b.GetData(), a.GetLength()) == 0;
+}
+
+// NOLINTNEXTLINE
+TEST(LogRecordTest, RoundTripTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 100}}};
+  const Tuple tuple({Value(TypeId::INTEGER, 42), Value(TypeId::VARCHAR, std::string(50, 'a'))}, &schema);
+
+  LogRecord begin = RoundTrip(LogRecord(7, INVALID_LSN, LogRecordType::BEGIN));
+  EXPECT_EQ(LogRecordType::BEGIN, begin.GetLogRecordType());
+  EXPECT_EQ(7, begin.GetTxnId());
+  EXPECT_EQ(INVALID_LSN, begin.GetPrevLSN());
+  // Small ids take a byte each, after the 4 byte lsn, the size and the type.
+  EXPECT_EQ(8, begin.GetSize());
+
+  LogRecord commit = RoundTrip(LogRecord(1 << 20, 1 << 30, LogRecordType::COMMIT));
+  EXPECT_EQ(LogRecordType::COMMIT, commit.GetLogRecordType());
+  EXPECT_EQ(1 << 20, commit.GetTxnId());
+  EXPECT_EQ(1 << 30, commit.GetPrevLSN());
+
+  LogRecord insert = RoundTrip(LogRecord(1, 2, LogRecordType::INSERT, RID(3, 4), tuple));
+  EXPECT_EQ(LogRecordType::INSERT, insert.GetLogRecordType());
+  EXPECT_EQ(RID(3, 4), insert.GetInsertRID());
+  EXPECT_TRUE(SameTuple(tuple, insert.GetInserteTuple()));
+
+  LogRecord mark_delete = RoundTrip(LogRecord(1, 2, LogRecordType::MARKDELETE, RID(5, 6), Tuple()));
+  EXPECT_EQ(LogRecordType::MARKDELETE, mark_delete.GetLogRecordType());
+  EXPECT_EQ(RID(5, 6), mark_delete.GetDeleteRID());
+
+  LogRecord new_page = RoundTrip(LogRecord(1, 2, LogRecordType::NEWPAGE, INVALID_PAGE_ID, 9));
+  EXPECT_EQ(LogRecordType::NEWPAGE, new_page.GetLogRecordType());
+  EXPECT_EQ(INVALID_PAGE_ID, new_page.GetNewPageRecord());
+
+  LogRecord clr = RoundTrip(LogRecord(LogRecord(1, 2, LogRecordType::APPLYDELETE, RID(3, 4), tuple), 8));
+  EXPECT_EQ(LogRecordType::CLR, clr.GetLogRecordType());
+  EXPECT_EQ(8, clr.GetUndoNextLSN());
+  EXPECT_EQ(RID(3, 4), clr.GetDeleteRID());
+
+  LogRecord checkpoint = RoundTrip(LogRecord(10, 1 << 24, {{1, 5}, {2, INVALID_LSN}}, {{3, 7}}));
+  EXPECT_EQ(LogRecordType::ENDCHECKPOINT, checkpoint.GetLogRecordType());
+  EXPECT_EQ(10, checkpoint.GetPrevLSN());
+}
+
+// NOLINTNEXTLINE
+TEST(LogRecordTest, UpdateTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::BIGINT}, Column{"c", TypeId::VARCHAR, 100}}};
+  auto make_tuple = [&schema](int a, int64_t b, const std::string &c) {
+    return Tuple({Value(TypeId::INTEGER, a), Value(TypeId::BIGINT, b), Value(TypeId::VARCHAR, c)}, &schema);
+  };
+  const Tuple old_tuple = make_tuple(1, 1000, std::string(60, 'x'));
+  const std::vector<Tuple> new_tuples{
+      // one fixed size column changes
+      make_tuple(2, 1000, std::string(60, 'x')),
+      // two columns change
+      make_tuple(2, 1001, std::string(60, 'x')),
+      // the varchar changes size
+      make_tuple(1, 1000, std::string(70, 'x')),
+      make_tuple(1, 1000, "y"),
+      // nothing changes
+      make_tuple(1, 1000, std::string(60, 'x')),
+  };
+  for (const auto &new_tuple : new_tuples) {
+    LogRecord log_record = RoundTrip(LogRecord(1, 2, LogRecordType::UPDATE, RID(3, 4), old_tuple, new_tuple));
+    Tuple tuple;
+    ASSERT_TRUE(log_record.ApplyUpdate(old_tuple, &tuple));
+    EXPECT_TRUE(SameTuple(new_tuple, tuple));
+    ASSERT_TRUE(log_record.RevertUpdate(new_tuple, &tuple));
+    EXPECT_TRUE(SameTuple(old_tuple, tuple));
+  }
+
+  // Only the bytes that changed are logged.
+  LogRecord log_record(1, 2, LogRecordType::UPDATE, RID(3, 4), old_tuple, new_tuples[0]);
+  EXPECT_LT(log_record.GetSize(), 20);
+  // A tuple the record was not logged for is rejected.
+  Tuple tuple;
+  EXPECT_FALSE(log_record.ApplyUpdate(new_tuples[1], &tuple));
+  EXPECT_FALSE(log_record.ApplyUpdate(new_tuples[2], &tuple));
+  EXPECT_FALSE(log_record.RevertUpdate(old_tuple, &tuple));
+}
+
+// NOLINTNEXTLINE
+TEST(LogRecordTest, MalformedTest) {
+  LogRecord log_record;
+  std::vector<char> zeros(64, 0);
+  EXPECT_FALSE(log_record.DeserializeFrom(zeros.data(), zeros.size()));
+
+  // A record whose size does not match its fields is rejected.
+  LogRecord begin(1, 2, LogRecordType::BEGIN);
+  std::vector<char> data(begin.GetSize() + 1);
+  begin.SerializeTo(data.data());
+  data[4]++;
+  EXPECT_FALSE(log_record.DeserializeFrom(data.data(), data.size()));
+  // So is an unknown type.
+  data[4]--;
+  data[5] = 100;
+  EXPECT_FALSE(log_record.DeserializeFrom(data.data(), data.size()));
+}
+
+}  // namespace bustub
@@ -10,7 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "common/bustub_instance.h"
@@ -27,9 +32,9 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(RecoveryTest, DISABLED_RedoTest) {
+TEST(RecoveryTest, RedoTest) {
   remove("test.db");
-  remove("test.log");
+  DiskManager::RemoveLogFiles("test.db");
 
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
@@ -88,7 +93,8 @@ TEST(RecoveryTest, DISABLED_RedoTest) {
   delete txn;
 
   LOG_INFO("Begin recovery");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
 
   ASSERT_FALSE(enable_logging);
 
@@ -118,13 +124,13 @@ TEST(RecoveryTest, DISABLED_RedoTest) {
   delete bustub_instance;
   LOG_INFO("Tearing down the system..");
   remove("test.db");
-  remove("test.log");
+  DiskManager::RemoveLogFiles("test.db");
 }
 
 // NOLINTNEXTLINE
-TEST(RecoveryTest, DISABLED_UndoTest) {
+TEST(RecoveryTest, UndoTest) {
   remove("test.db");
-  remove("test.log");
+  DiskManager::RemoveLogFiles("test.db");
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -177,7 +183,8 @@ TEST(RecoveryTest, DISABLED_UndoTest) {
   delete txn;
 
   LOG_INFO("Recovery started..");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
 
   ASSERT_FALSE(enable_logging);
 
@@ -202,13 +209,92 @@ TEST(RecoveryTest, DISABLED_UndoTest) {
   delete bustub_instance;
   LOG_INFO("Tearing down the system..");
   remove("test.db");
-  remove("test.log");
+  DiskManager::RemoveLogFiles("test.db");
 }
 
 // NOLINTNEXTLINE
-TEST(RecoveryTest, DISABLED_CheckpointTest) {
+TEST(RecoveryTest, RepeatedRecoveryTest) {
   remove("test.db");
-  remove("test.log");
+  DiskManager::RemoveLogFiles("test.db");
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+  const Tuple uncommitted_tuple = ConstructTuple(&schema);
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // A transaction that does not commit updates the tuple and inserts another one, the page is written.
+  txn = bustub_instance->transaction_manager_->Begin();
+  RID uncommitted_rid;
+  ASSERT_TRUE(test_table->UpdateTuple(ConstructTuple(&schema), rid, txn));
+  ASSERT_TRUE(test_table->InsertTuple(uncommitted_tuple, &uncommitted_rid, txn));
+  bustub_instance->log_manager_->Flush(bustub_instance->log_manager_->GetNextLSN() - 1);
+  bustub_instance->buffer_pool_manager_->FlushPage(first_page_id);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  auto recover = [] {
+    auto *bustub_instance = new BustubInstance("test.db");
+    LogRecovery log_recovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                             bustub_instance->log_manager_);
+    log_recovery.Redo();
+    log_recovery.Undo();
+    return bustub_instance;
+  };
+
+  // The undone page is written, and a committed transaction reuses the slot of the undone insert.
+  bustub_instance = recover();
+  bustub_instance->log_manager_->RunFlushThread();
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  const Tuple new_tuple = ConstructTuple(&schema);
+  RID new_rid;
+  ASSERT_TRUE(test_table->InsertTuple(new_tuple, &new_rid, txn));
+  EXPECT_EQ(uncommitted_rid, new_rid);
+  bustub_instance->transaction_manager_->Commit(txn);
+  bustub_instance->buffer_pool_manager_->FlushPage(first_page_id);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  // Recovering again after the crash does not undo the rolled back transaction twice.
+  bustub_instance = recover();
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple result;
+  ASSERT_TRUE(test_table->GetTuple(rid, &result, txn));
+  ASSERT_EQ(tuple.GetLength(), result.GetLength());
+  EXPECT_EQ(0, memcmp(tuple.GetData(), result.GetData(), tuple.GetLength()));
+  ASSERT_TRUE(test_table->GetTuple(new_rid, &result, txn));
+  ASSERT_EQ(new_tuple.GetLength(), result.GetLength());
+  EXPECT_EQ(0, memcmp(new_tuple.GetData(), result.GetData(), new_tuple.GetLength()));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, CheckpointTest) {
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   EXPECT_FALSE(enable_logging);
@@ -312,6 +398,395 @@ TEST(RecoveryTest, DISABLED_CheckpointTest) {
 
   LOG_INFO("Tearing down the system..");
   remove("test.db");
-  remove("test.log");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, ParallelRedoTest) {
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+  auto *bustub_instance = new BustubInstance("test.db", 16);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  // A committed transaction inserts, updates and deletes tuples over many pages.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 4000;
+  std::vector<RID> rids(num_tuples);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.push_back(ConstructTuple(&schema));
+    ASSERT_TRUE(test_table->InsertTuple(tuples[i], &rids[i], txn));
+  }
+  for (int i = 0; i < num_tuples; i += 7) {
+    // An update that does not fit in the page fails.
+    Tuple new_tuple = ConstructTuple(&schema);
+    if (test_table->UpdateTuple(new_tuple, rids[i], txn)) {
+      tuples[i] = new_tuple;
+    }
+  }
+  for (int i = 0; i < num_tuples; i += 11) {
+    ASSERT_TRUE(test_table->MarkDelete(rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // The inserts of a transaction that did not commit are undone.
+  Transaction *uncommitted_txn = bustub_instance->transaction_manager_->Begin();
+  std::vector<RID> uncommitted_rids(100);
+  for (auto &rid : uncommitted_rids) {
+    ASSERT_TRUE(test_table->InsertTuple(ConstructTuple(&schema), &rid, uncommitted_txn));
+  }
+  bustub_instance->log_manager_->Flush(bustub_instance->log_manager_->GetNextLSN() - 1);
+  delete uncommitted_txn;
+  delete test_table;
+  delete bustub_instance;
+
+  bustub_instance = new BustubInstance("test.db", 16);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_, 4);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  bustub_instance->log_manager_->SetNextLSN(log_recovery->GetNextLSN());
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple tuple;
+  for (int i = 0; i < num_tuples; i++) {
+    if (i % 11 == 0) {
+      EXPECT_FALSE(test_table->GetTuple(rids[i], &tuple, txn));
+      continue;
+    }
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    ASSERT_EQ(tuples[i].GetLength(), tuple.GetLength());
+    EXPECT_EQ(0, memcmp(tuples[i].GetData(), tuple.GetData(), tuple.GetLength()));
+  }
+  for (const auto &rid : uncommitted_rids) {
+    EXPECT_FALSE(test_table->GetTuple(rid, &tuple, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, CompressedLogTest) {
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+  auto *bustub_instance = new BustubInstance("test.db", 16, true);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  // A committed transaction inserts and updates tuples.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 1000;
+  std::vector<RID> rids(num_tuples);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.push_back(ConstructTuple(&schema));
+    ASSERT_TRUE(test_table->InsertTuple(tuples[i], &rids[i], txn));
+  }
+  for (int i = 0; i < num_tuples; i += 3) {
+    Tuple new_tuple = ConstructTuple(&schema);
+    if (test_table->UpdateTuple(new_tuple, rids[i], txn)) {
+      tuples[i] = new_tuple;
+    }
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // The updates and deletes of a transaction that did not commit are undone.
+  Transaction *uncommitted_txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = 0; i < num_tuples; i += 5) {
+    test_table->UpdateTuple(ConstructTuple(&schema), rids[i], uncommitted_txn);
+  }
+  for (int i = 1; i < num_tuples; i += 5) {
+    ASSERT_TRUE(test_table->MarkDelete(rids[i], uncommitted_txn));
+  }
+  bustub_instance->log_manager_->Flush(bustub_instance->log_manager_->GetNextLSN() - 1);
+  delete uncommitted_txn;
+  delete test_table;
+  delete bustub_instance;
+
+  // The records are compressed.
+  std::vector<char> frame(LogManager::MAX_FRAME_SIZE);
+  {
+    DiskManager disk_manager("test.db");
+    ASSERT_TRUE(disk_manager.ReadLog(frame.data(), LogManager::FRAME_HEADER_SIZE, 0));
+    size_t frame_size = LogManager::GetFrameSize(frame.data());
+    ASSERT_TRUE(disk_manager.ReadLog(frame.data(), frame_size, 0));
+    std::vector<char> records(LOG_BUFFER_SIZE);
+    size_t records_size;
+    ASSERT_EQ(records.data(), LogManager::GetFrameRecords(frame.data(), records.data(), &records_size));
+    EXPECT_LT(frame_size - LogManager::FRAME_HEADER_SIZE, records_size);
+    disk_manager.ShutDown();
+  }
+
+  bustub_instance = new BustubInstance("test.db", 16);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  bustub_instance->log_manager_->SetNextLSN(log_recovery->GetNextLSN());
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple tuple;
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    ASSERT_EQ(tuples[i].GetLength(), tuple.GetLength());
+    EXPECT_EQ(0, memcmp(tuples[i].GetData(), tuple.GetData(), tuple.GetLength()));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, FuzzyCheckpointTest) {
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+  // The pool holds every page, only the pages that were flushed are on disk.
+  auto *bustub_instance = new BustubInstance("test.db", 64);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  std::vector<RID> rids;
+  std::vector<Tuple> tuples;
+  auto insert = [&](Transaction *txn, int num_tuples) {
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      tuples.push_back(ConstructTuple(&schema));
+      ASSERT_TRUE(test_table->InsertTuple(tuples.back(), &rid, txn));
+      rids.push_back(rid);
+    }
+  };
+  insert(txn, 2000);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  // Recovery skips the records of the pages that are clean at the checkpoint, and replays the dirty pages from their
+  // recLSN.
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+  txn = bustub_instance->transaction_manager_->Begin();
+  insert(txn, 200);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // A transaction that never commits runs across the checkpoint.
+  Transaction *uncommitted_txn = bustub_instance->transaction_manager_->Begin();
+  std::vector<RID> uncommitted_rids(50);
+  for (auto &rid : uncommitted_rids) {
+    ASSERT_TRUE(test_table->InsertTuple(ConstructTuple(&schema), &rid, uncommitted_txn));
+  }
+
+  bustub_instance->checkpoint_manager_->FuzzyCheckpoint();
+  size_t checkpoint_offset;
+  lsn_t checkpoint_lsn;
+  ASSERT_TRUE(bustub_instance->disk_manager_->GetCheckpoint(&checkpoint_offset, &checkpoint_lsn));
+  EXPECT_LE(checkpoint_lsn, bustub_instance->log_manager_->GetPersistentLSN());
+  // The checkpoint does not write the pages.
+  Page *pages = bustub_instance->buffer_pool_manager_->GetPages();
+  EXPECT_TRUE(std::any_of(pages, pages + bustub_instance->buffer_pool_manager_->GetPoolSize(),
+                          [](Page &page) { return page.GetPageId() != INVALID_PAGE_ID && page.IsDirty(); }));
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  insert(txn, 200);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  for (int i = 0; i < 50; i++) {
+    uncommitted_rids.emplace_back();
+    ASSERT_TRUE(test_table->InsertTuple(ConstructTuple(&schema), &uncommitted_rids.back(), uncommitted_txn));
+  }
+  bustub_instance->log_manager_->Flush(bustub_instance->log_manager_->GetNextLSN() - 1);
+  delete uncommitted_txn;
+  delete test_table;
+  delete bustub_instance;
+
+  bustub_instance = new BustubInstance("test.db", 64);
+  size_t restart_checkpoint_offset;
+  lsn_t restart_checkpoint_lsn;
+  ASSERT_TRUE(bustub_instance->disk_manager_->GetCheckpoint(&restart_checkpoint_offset, &restart_checkpoint_lsn));
+  EXPECT_EQ(checkpoint_offset, restart_checkpoint_offset);
+  EXPECT_EQ(checkpoint_lsn, restart_checkpoint_lsn);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple tuple;
+  for (size_t i = 0; i < rids.size(); i++) {
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    ASSERT_EQ(tuples[i].GetLength(), tuple.GetLength());
+    EXPECT_EQ(0, memcmp(tuples[i].GetData(), tuple.GetData(), tuple.GetLength()));
+  }
+  for (const auto &rid : uncommitted_rids) {
+    EXPECT_FALSE(test_table->GetTuple(rid, &tuple, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, DISABLED_CheckpointLatencyBenchmark) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+  const int num_tuples = 50000;
+  const int num_threads = 4;
+
+  // Transactions update random tuples while a checkpoint is taken every 100 ms. The pool holds every page, and the
+  // updates keep many of them dirty.
+  for (bool fuzzy : {false, true}) {
+    remove("test.db");
+    DiskManager::RemoveLogFiles("test.db");
+    auto *bustub_instance = new BustubInstance("test.db", 4096);
+    bustub_instance->log_manager_->RunFlushThread();
+    Transaction *txn = bustub_instance->transaction_manager_->Begin();
+    auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                     bustub_instance->log_manager_, txn);
+    std::vector<RID> rids(num_tuples);
+    for (auto &rid : rids) {
+      ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+    }
+    bustub_instance->transaction_manager_->Commit(txn);
+    delete txn;
+    bustub_instance->buffer_pool_manager_->RunPageCleaner();
+
+    std::atomic<bool> stop{false};
+    std::vector<std::vector<double>> latencies(num_threads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&, i] {
+        unsigned int seed = i;
+        while (!stop) {
+          auto start = std::chrono::steady_clock::now();
+          Transaction *txn = bustub_instance->transaction_manager_->Begin();
+          if (test_table->UpdateTuple(tuple, rids[rand_r(&seed) % num_tuples], txn)) {
+            bustub_instance->transaction_manager_->Commit(txn);
+          } else {
+            bustub_instance->transaction_manager_->Abort(txn);
+          }
+          delete txn;
+          std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+          latencies[i].push_back(elapsed.count());
+        }
+      });
+    }
+    for (int i = 0; i < 20; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      if (fuzzy) {
+        bustub_instance->checkpoint_manager_->FuzzyCheckpoint();
+      } else {
+        bustub_instance->checkpoint_manager_->BeginCheckpoint();
+        bustub_instance->checkpoint_manager_->EndCheckpoint();
+      }
+    }
+    stop = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    std::vector<double> all_latencies;
+    for (const auto &thread_latencies : latencies) {
+      all_latencies.insert(all_latencies.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    std::sort(all_latencies.begin(), all_latencies.end());
+    size_t num_txns = all_latencies.size();
+    std::cout << (fuzzy ? "fuzzy" : "blocking") << " checkpoints: " << num_txns << " txns, p50 "
+              << all_latencies[num_txns / 2] << " us, p99 " << all_latencies[num_txns * 99 / 100] << " us, max "
+              << all_latencies.back() << " us" << std::endl;
+    delete test_table;
+    delete bustub_instance;
+  }
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, DISABLED_RedoBenchmark) {
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
+  // The pool holds every page, nothing is written to the database file, so each recovery starts from the same state.
+  const size_t pool_size = 8192;
+  auto *bustub_instance = new BustubInstance("test.db", pool_size);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const int num_tuples = 100000;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(test_table->InsertTuple(ConstructTuple(&schema), &rid, txn));
+    if (i % 1000 == 999) {
+      bustub_instance->transaction_manager_->Commit(txn);
+      delete txn;
+      txn = bustub_instance->transaction_manager_->Begin();
+    }
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  for (size_t num_threads : {1, 2, 4, 8}) {
+    bustub_instance = new BustubInstance("test.db", pool_size);
+    auto start = std::chrono::steady_clock::now();
+    LogRecovery log_recovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                             bustub_instance->log_manager_, num_threads);
+    log_recovery.Redo();
+    log_recovery.Undo();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << num_threads << " redo threads: " << elapsed.count() << " ms" << std::endl;
+    delete bustub_instance;
+  }
+  remove("test.db");
+  DiskManager::RemoveLogFiles("test.db");
 }
 }  // namespace bustub
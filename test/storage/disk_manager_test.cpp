@@ -12,10 +12,30 @@
 
 #include "storage/disk/disk_manager.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>  // NOLINT
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
+#include "common/util/crc32c_util.h"
 #include "gtest/gtest.h"
+#include "storage/disk/compressed_disk_manager.h"
+#include "storage/disk/mmap_disk_manager.h"
+#include "storage/disk/posix_disk_manager.h"
+#include "storage/disk/uring_disk_manager.h"
 
 namespace bustub {
 
@@ -46,6 +66,7 @@ TEST(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
   char data[16] = {0};
   std::string db_file("test.db");
+  DiskManager::RemoveLogFiles(db_file);
   auto dm = DiskManager(db_file);
   std::strncpy(data, "A test string.", sizeof(data));
 
@@ -57,6 +78,528 @@ TEST(DiskManagerTest, ReadWriteLogTest) {
 
   dm.ShutDown();
   remove(db_file.c_str());
+  DiskManager::RemoveLogFiles(db_file);
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, LogSegmentTest) {
+  std::string db_file("test.db");
+  remove(db_file.c_str());
+  DiskManager::RemoveLogFiles(db_file);
+  // Alternate between two buffers, WriteLog checks that the log buffers are swapped.
+  const size_t segment_size = LOG_SEGMENT_SIZE;
+  const size_t chunk_size = segment_size / 3;
+  std::vector<char> chunks[2] = {std::vector<char>(chunk_size), std::vector<char>(chunk_size)};
+  std::vector<size_t> offsets;
+  {
+    DiskManager dm(db_file);
+    EXPECT_EQ(0U, dm.GetLogStartOffset());
+    EXPECT_EQ(0U, dm.GetLogOffset());
+    for (int i = 0; i < 7; i++) {
+      auto &chunk = chunks[i % 2];
+      std::fill(chunk.begin(), chunk.end(), static_cast<char>('a' + i));
+      dm.WriteLog(chunk.data(), chunk_size);
+      // The fourth chunk does not fit in the rest of the first segment.
+      size_t offset = dm.GetLogOffset() - chunk_size;
+      EXPECT_EQ(i / 3 * segment_size + i % 3 * chunk_size, offset);
+      offsets.push_back(offset);
+    }
+    EXPECT_EQ(2 * segment_size + chunk_size, dm.GetLogOffset());
+
+    char buf[16];
+    for (int i = 0; i < 7; i++) {
+      ASSERT_TRUE(dm.ReadLog(buf, sizeof(buf), offsets[i] + chunk_size - sizeof(buf)));
+      EXPECT_TRUE(std::all_of(buf, buf + sizeof(buf), [i](char c) { return c == 'a' + i; }));
+    }
+    // The padding at the end of a segment reads as zeros, reads stop at the end of the log.
+    ASSERT_TRUE(dm.ReadLog(buf, sizeof(buf), segment_size - 1));
+    EXPECT_TRUE(std::all_of(buf, buf + sizeof(buf), [](char c) { return c == 0; }));
+    EXPECT_FALSE(dm.ReadLog(buf, sizeof(buf), dm.GetLogOffset()));
+
+    // Segments are preallocated.
+    struct stat stat_buf;
+    ASSERT_EQ(0, stat("test.log.2", &stat_buf));
+    EXPECT_EQ(LOG_SEGMENT_SIZE, stat_buf.st_size);
+
+    // The first segment becomes a spare file, the segment being written is kept.
+    dm.RecycleLog(segment_size + chunk_size);
+    EXPECT_EQ(segment_size, dm.GetLogStartOffset());
+    EXPECT_FALSE(dm.ReadLog(buf, sizeof(buf), 0));
+    EXPECT_TRUE(dm.ReadLog(buf, sizeof(buf), segment_size));
+    EXPECT_EQ(0, stat("test.log.0.spare", &stat_buf));
+    dm.RecycleLog(dm.GetLogOffset());
+    EXPECT_EQ(2 * segment_size, dm.GetLogStartOffset());
+    dm.ShutDown();
+  }
+  {
+    // A restart keeps the segments and writes a new one, made from a spare file.
+    DiskManager dm(db_file);
+    EXPECT_EQ(2 * segment_size, dm.GetLogStartOffset());
+    EXPECT_EQ(3 * segment_size, dm.GetLogOffset());
+    char buf[16];
+    ASSERT_TRUE(dm.ReadLog(buf, sizeof(buf), 2 * segment_size));
+    EXPECT_EQ('a' + 6, buf[0]);
+    dm.WriteLog(chunks[1].data(), chunk_size);
+    struct stat stat_buf;
+    EXPECT_NE(0, stat("test.log.1.spare", &stat_buf));
+    EXPECT_EQ(0, stat("test.log.3", &stat_buf));
+    ASSERT_TRUE(dm.ReadLog(buf, sizeof(buf), 3 * segment_size));
+    EXPECT_EQ('a' + 5, buf[0]);
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+  DiskManager::RemoveLogFiles(db_file);
+  struct stat stat_buf;
+  EXPECT_NE(0, stat("test.log.0.spare", &stat_buf));
+  EXPECT_NE(0, stat("test.log.3", &stat_buf));
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, PosixReadWritePageTest) {
+  for (bool direct_io : {false, true}) {
+    char buf[PAGE_SIZE] = {0};
+    char data[PAGE_SIZE] = {0};
+    std::string db_file("test.db");
+    auto dm = PosixDiskManager(db_file, direct_io);
+    std::strncpy(data, "A test string.", sizeof(data));
+
+    dm.ReadPage(0, buf);  // tolerate empty read
+
+    // The stack buffers are not necessarily aligned, which exercises the bounce buffer with O_DIRECT.
+    dm.WritePage(0, data);
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+    std::memset(buf, 0, sizeof(buf));
+    dm.WritePage(5, data);
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    EXPECT_EQ(2, dm.GetNumWrites());
+
+    dm.ShutDown();
+    remove(db_file.c_str());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, PosixConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  auto dm = PosixDiskManager(db_file);
+
+  // Scenario: every thread writes and reads back its own pages, interleaved with the other threads.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&dm, t] {
+      char buf[PAGE_SIZE];
+      char data[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id = i * num_threads + t;
+        std::memset(data, 0, sizeof(data));
+        snprintf(data, sizeof(data), "page %d", page_id);
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+
+  dm.ShutDown();
+  remove(db_file.c_str());
+}
+
+// Writes pages asynchronously with many requests in flight, then reads them back the same way.
+static void CheckAsyncReadWrite(DiskManager *dm) {
+  const int num_pages = 200;
+  // Aligned buffers, so that the io_uring manager does not fall back to the thread pool.
+  std::unique_ptr<char, decltype(&free)> buffers(
+      static_cast<char *>(aligned_alloc(PAGE_SIZE, 2 * num_pages * PAGE_SIZE)), &free);
+  char *data = buffers.get();
+  char *buf = buffers.get() + num_pages * PAGE_SIZE;
+  std::memset(buffers.get(), 0, 2 * num_pages * PAGE_SIZE);
+
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < num_pages; ++i) {
+    snprintf(data + i * PAGE_SIZE, PAGE_SIZE, "page %d", i);
+    futures.push_back(dm->WritePageAsync(i, data + i * PAGE_SIZE));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+  futures.clear();
+  for (int i = num_pages - 1; i >= 0; --i) {
+    futures.push_back(dm->ReadPageAsync(i, buf + i * PAGE_SIZE));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+  EXPECT_EQ(std::memcmp(buf, data, num_pages * PAGE_SIZE), 0);
+  EXPECT_EQ(num_pages, dm->GetNumWrites());
+
+  // Scenario: reading a page past the end of the file yields zeros.
+  std::memset(buf, 'x', PAGE_SIZE);
+  dm->ReadPageAsync(num_pages + 10, buf).get();
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_EQ(0, buf[PAGE_SIZE - 1]);
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, AsyncReadWritePageTest) {
+  std::string db_file("test.db");
+  {
+    DiskManager dm(db_file);
+    CheckAsyncReadWrite(&dm);
+    dm.ShutDown();
+    remove(db_file.c_str());
+  }
+  {
+    PosixDiskManager dm(db_file);
+    CheckAsyncReadWrite(&dm);
+    dm.ShutDown();
+    remove(db_file.c_str());
+  }
+  for (bool direct_io : {false, true}) {
+    UringDiskManager dm(db_file, direct_io);
+    CheckAsyncReadWrite(&dm);
+    dm.ShutDown();
+    remove(db_file.c_str());
+  }
+}
+
+// Compares random page reads with one request in flight to 32 requests in flight, for the I/O thread pool and for
+// io_uring. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, DISABLED_AsyncRandomReadBenchmark) {
+  const int num_pages = 16384;
+  const int num_reads = 50000;
+  const int max_queue_depth = 32;
+  std::string db_file("test.db");
+
+  std::unique_ptr<char, decltype(&free)> buffers(
+      static_cast<char *>(aligned_alloc(PAGE_SIZE, max_queue_depth * PAGE_SIZE)), &free);
+  std::memset(buffers.get(), 0, max_queue_depth * PAGE_SIZE);
+  {
+    PosixDiskManager dm(db_file);
+    for (int i = 0; i < num_pages; ++i) {
+      dm.WritePage(i, buffers.get());
+    }
+    dm.ShutDown();
+  }
+
+  for (bool use_uring : {false, true}) {
+    for (int queue_depth : {1, max_queue_depth}) {
+      std::unique_ptr<DiskManager> dm(use_uring ? new UringDiskManager(db_file, true)
+                                                : new PosixDiskManager(db_file, true));
+      std::mt19937 gen(0);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      std::deque<std::pair<std::future<void>, char *>> in_flight;
+      for (int i = 0; i < queue_depth; ++i) {
+        in_flight.emplace_back(std::future<void>(), buffers.get() + i * PAGE_SIZE);
+      }
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < num_reads; ++i) {
+        // Reuse the buffer of the oldest request once it is done.
+        auto [future, buffer] = std::move(in_flight.front());
+        in_flight.pop_front();
+        if (future.valid()) {
+          future.get();
+        }
+        in_flight.emplace_back(dm->ReadPageAsync(dist(gen), buffer), buffer);
+      }
+      for (auto &request : in_flight) {
+        request.first.get();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "backend=" << (use_uring ? "io_uring" : "thread_pool") << " queue_depth=" << queue_depth
+                << " reads/s=" << num_reads / elapsed.count() << std::endl;
+      dm->ShutDown();
+    }
+  }
+  remove(db_file.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, AllocatePageTest) {
+  std::string db_file("test.db");
+  remove(db_file.c_str());
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id = 0; page_id < 10; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+    }
+    // Deallocated pages are reused, lowest first.
+    dm.DeallocatePage(7);
+    dm.DeallocatePage(3);
+    EXPECT_EQ(3, dm.AllocatePage());
+    dm.DeallocatePage(5);
+    EXPECT_EQ(5, dm.AllocatePage());
+    dm.ShutDown();
+  }
+  {
+    // The allocation bitmap survives a restart.
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(7, dm.AllocatePage());
+    EXPECT_EQ(10, dm.AllocatePage());
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, ShrinkFileTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  remove(db_file.c_str());
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  const page_id_t num_pages = 100;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    page_id_t page_id = dm.AllocatePage();
+    dm.WritePage(page_id, data);
+  }
+  struct stat before;
+  ASSERT_EQ(0, stat(db_file.c_str(), &before));
+
+  // Free everything but page 10, the file ends right after it.
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    if (page_id != 10) {
+      dm.DeallocatePage(page_id);
+    }
+  }
+  dm.ShrinkFile();
+  struct stat after;
+  ASSERT_EQ(0, stat(db_file.c_str(), &after));
+  EXPECT_LT(after.st_size, before.st_size);
+  EXPECT_LT(after.st_blocks, before.st_blocks);
+
+  dm.ReadPage(10, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(0, dm.AllocatePage());
+  dm.ShutDown();
+
+  // A file which is not a database is rejected.
+  std::memset(data, 'x', sizeof(data));
+  std::ofstream(db_file, std::ios::binary | std::ios::trunc).write(data, sizeof(data));
+  EXPECT_THROW(DiskManager{db_file}, Exception);
+  remove(db_file.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, PageSizeMismatchTest) {
+  std::string db_file("test.db");
+  remove(db_file.c_str());
+  {
+    DiskManager dm(db_file);
+    dm.ShutDown();
+  }
+  // Pretend the file was created by a build with twice the page size: the superblock records the page size after
+  // the 8-byte magic and the 4-byte version.
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    uint32_t page_size = 2 * PAGE_SIZE;
+    file.seekp(12);
+    file.write(reinterpret_cast<const char *>(&page_size), sizeof(page_size));
+  }
+  try {
+    DiskManager dm(db_file);
+    dm.ShutDown();
+    FAIL() << "a file with a different page size was opened";
+  } catch (const Exception &e) {
+    EXPECT_NE(std::string::npos, std::string(e.what()).find("page size " + std::to_string(2 * PAGE_SIZE)));
+  }
+  remove(db_file.c_str());
+}
+
+// Flips a byte of the page holding the marker in the database file, as a torn or corrupted write would.
+static void CorruptPage(const std::string &db_file, const char *marker) {
+  std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  auto pos = content.find(marker);
+  ASSERT_NE(std::string::npos, pos);
+  file.seekp(pos + 100);
+  file.put('x');
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, ChecksumTest) {
+  std::string db_file("test.db");
+  remove(db_file.c_str());
+  std::unique_ptr<char, decltype(&free)> buffers(static_cast<char *>(aligned_alloc(PAGE_SIZE, 3 * PAGE_SIZE)), &free);
+  char *data = buffers.get();
+  char *other = buffers.get() + PAGE_SIZE;
+  char *buf = buffers.get() + 2 * PAGE_SIZE;
+  std::memset(buffers.get(), 0, 3 * PAGE_SIZE);
+  std::strncpy(data, "A test string.", PAGE_SIZE);
+  std::strncpy(other, "B test string.", PAGE_SIZE);
+
+  {
+    DiskManager dm(db_file);
+    dm.WritePage(0, data);
+    dm.WritePage(1, other);
+    // The checksum is not visible to the reader.
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+
+    CorruptPage(db_file, "A test string.");
+    EXPECT_THROW(dm.ReadPage(0, buf), Exception);
+    dm.ReadPage(1, buf);
+    EXPECT_STREQ("B test string.", buf);
+    dm.ShutDown();
+  }
+  {
+    // The same through io_uring, where the checksum is verified by the reaper thread.
+    UringDiskManager dm(db_file, true);
+    EXPECT_THROW(dm.ReadPageAsync(0, buf).get(), Exception);
+    dm.WritePageAsync(2, data).get();
+    dm.ReadPageAsync(2, buf).get();
+    EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, MmapReadPageTest) {
+  char data[PAGE_SIZE] = {0};
+  char other[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  remove(db_file.c_str());
+  std::strncpy(data, "A test string.", PAGE_SIZE);
+  std::strncpy(other, "B test string.", PAGE_SIZE);
+  {
+    DiskManager dm(db_file);
+    for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+    }
+    dm.WritePage(0, data);
+    dm.WritePage(1, other);
+    dm.ShutDown();
+  }
+  CorruptPage(db_file, "B test string.");
+
+  MmapDiskManager dm(db_file);
+  EXPECT_EQ(3, dm.GetNumPages());
+  const char *page = dm.GetPageData(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("A test string.", page);
+  dm.VerifyPage(0);
+  ASSERT_NE(nullptr, dm.GetPageData(1));
+  EXPECT_THROW(dm.VerifyPage(1), Exception);
+  // Page 2 was allocated but never written, page 3 was never allocated.
+  page = dm.GetPageData(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_TRUE(std::all_of(page, page + PAGE_SIZE, [](char c) { return c == 0; }));
+  dm.VerifyPage(2);
+  EXPECT_EQ(nullptr, dm.GetPageData(3));
+
+  EXPECT_THROW(dm.WritePage(0, other), Exception);
+  char buf[PAGE_SIZE] = {0};
+  dm.ReadPage(0, buf);
+  EXPECT_STREQ("A test string.", buf);
+  dm.ShutDown();
+  remove(db_file.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, CompressedReadWritePageTest) {
+  std::string db_file("test.db");
+  std::string image_file("test.lz4");
+  remove(db_file.c_str());
+  remove(image_file.c_str());
+  const page_id_t num_pages = 64;
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  // Even pages compress well, odd pages are random. The round changes the random content.
+  auto fill = [&](page_id_t page_id, int round) {
+    std::mt19937 gen(page_id * 100 + round);
+    for (size_t i = 0; i < PAGE_SIZE - PAGE_CHECKSUM_SIZE; i++) {
+      data[i] = page_id % 2 == 0 ? static_cast<char>(i / 64 % 3) : static_cast<char>(gen());
+    }
+  };
+  {
+    CompressedDiskManager dm(db_file);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      EXPECT_EQ(i, dm.AllocatePage());
+      fill(i, 0);
+      dm.WritePage(i, data);
+    }
+    EXPECT_LT(dm.GetNumBytesWritten(), num_pages * PAGE_SIZE * 3 / 4);
+    // Rewrite with swapped compressibility so that the images move.
+    for (page_id_t i = 0; i < num_pages; i++) {
+      fill(i ^ 1, 1);
+      dm.WritePageAsync(i, data).get();
+    }
+    dm.ShutDown();
+  }
+  {
+    // The mapping table is rebuilt from the image file.
+    CompressedDiskManager dm(db_file);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      fill(i ^ 1, 1);
+      dm.ReadPage(i, buf);
+      EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    }
+    // A deallocated page comes back empty, also after a restart.
+    dm.DeallocatePage(3);
+    dm.ShutDown();
+  }
+  {
+    CompressedDiskManager dm(db_file);
+    EXPECT_EQ(3, dm.AllocatePage());
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, buf[0]);
+    EXPECT_EQ(0, buf[100]);
+    dm.ReadPageAsync(4, buf).get();
+    fill(5, 1);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    EXPECT_GT(dm.GetNumBytesRead(), 0);
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+  remove(image_file.c_str());
+}
+
+// Compares reading a page that is in the OS page cache to verifying its checksum. Run with
+// --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, DISABLED_ChecksumOverheadBenchmark) {
+  const int num_pages = 256;
+  const int num_reads = 200000;
+  std::string db_file("test.db");
+  remove(db_file.c_str());
+  PosixDiskManager dm(db_file);
+  std::unique_ptr<char, decltype(&free)> buffer(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)), &free);
+  char *buf = buffer.get();
+  std::memset(buf, 'a', PAGE_SIZE);
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    dm.WritePage(page_id, buf);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_reads; i++) {
+    dm.ReadPage(i % num_pages, buf);
+  }
+  std::chrono::duration<double, std::nano> read_time = std::chrono::steady_clock::now() - start;
+  uint32_t crc = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_reads; i++) {
+    crc = Crc32cUtil::Crc32c(buf, PAGE_SIZE - PAGE_CHECKSUM_SIZE, crc);
+  }
+  std::chrono::duration<double, std::nano> verify_time = std::chrono::steady_clock::now() - start;
+  EXPECT_NE(0, crc);
+
+  std::cout << "cached read (including verify): " << read_time.count() / num_reads << " ns/page" << std::endl;
+  std::cout << "verify: " << verify_time.count() / num_reads << " ns/page ("
+            << 100 * verify_time.count() / read_time.count() << "% of a cached read)" << std::endl;
+  dm.ShutDown();
+  remove(db_file.c_str());
 }
 
 TEST(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
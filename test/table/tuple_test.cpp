@@ -13,14 +13,19 @@
 #include "storage/table/tuple.h"
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "storage/disk/compressed_disk_manager.h"
+#include "storage/disk/mmap_disk_manager.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -66,10 +71,173 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   }
   disk_manager->ShutDown();
   remove("test.db");  // remove db file
-  remove("test.log");
+  DiskManager::RemoveLogFiles("test.db");
   delete table;
   delete buffer_pool_manager;
   delete disk_manager;
 }
 
+// Scans a table of low cardinality integers stored with and without compression, and compares the bytes read from
+// disk. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_CompressedScanBenchmark) {
+  const int num_tuples = 20000;
+  // The table is built in a pool large enough to hold it (every insert walks the table from its first page), and
+  // scanned through a small one. Inserts are quadratic, keep the table small.
+  const size_t load_buffer_pool_size = 256;
+  const size_t buffer_pool_size = 16;
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::INTEGER}, Column{"c", TypeId::BIGINT}}};
+  for (bool compressed : {false, true}) {
+    std::unique_ptr<DiskManager> disk_manager;
+    if (compressed) {
+      disk_manager = std::make_unique<CompressedDiskManager>("test.db");
+    } else {
+      disk_manager = std::make_unique<DiskManager>("test.db");
+    }
+    Transaction transaction(0);
+    page_id_t first_page_id;
+    {
+      BufferPoolManager bpm(load_buffer_pool_size, disk_manager.get());
+      TableHeap table(&bpm, nullptr, nullptr, &transaction);
+      for (int i = 0; i < num_tuples; ++i) {
+        Tuple tuple({Value(TypeId::INTEGER, i % 4), Value(TypeId::INTEGER, i / 1000),
+                     Value(TypeId::BIGINT, static_cast<int64_t>(i % 16))},
+                    &schema);
+        RID rid;
+        ASSERT_TRUE(table.InsertTuple(tuple, &rid, &transaction));
+      }
+      first_page_id = table.GetFirstPageId();
+      bpm.FlushAllPages();
+    }
+
+    BufferPoolManager bpm(buffer_pool_size, disk_manager.get());
+    TableHeap table(&bpm, nullptr, nullptr, first_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto itr = table.Begin(&transaction); itr != table.End(); ++itr) {
+      count++;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(num_tuples, count);
+    size_t bytes_read = compressed ? dynamic_cast<CompressedDiskManager *>(disk_manager.get())->GetNumBytesRead()
+                                   : bpm.GetNumMisses() * PAGE_SIZE;
+    std::cout << (compressed ? "compressed:   " : "uncompressed: ") << bpm.GetNumMisses() << " pages, " << bytes_read
+              << " bytes read, " << elapsed.count() << " ms" << std::endl;
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.lz4");
+  }
+}
+
+// Loads num_tuples tuples of about 128 bytes into a new table heap of the database file and flushes it.
+void LoadBenchmarkTable(DiskManager *disk_manager, int num_tuples, Transaction *transaction, page_id_t *first_page_id,
+                        std::vector<RID> *rids) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 100}}};
+  // Inserts walk the table from its first page, keep it in memory while loading.
+  BufferPoolManager bpm(4 * (num_tuples * 128 / PAGE_SIZE + 1), disk_manager);
+  TableHeap table(&bpm, nullptr, nullptr, transaction);
+  for (int i = 0; i < num_tuples; ++i) {
+    Tuple tuple({Value(TypeId::INTEGER, i), Value(TypeId::VARCHAR, std::string(100, 'a' + i % 26))}, &schema);
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(tuple, &rid, transaction));
+    rids->push_back(rid);
+  }
+  *first_page_id = table.GetFirstPageId();
+  bpm.FlushAllPages();
+}
+
+// Measures scan and point lookup throughput over a table larger than the buffer pool, at the page size of the build.
+// The pool gets the same memory at every page size. Compare page sizes by building with -DBUSTUB_PAGE_SIZE=4096,
+// 16384 and 65536 and running with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_PageSizeBenchmark) {
+  const int num_tuples = 20000;
+  const int num_lookups = 100000;
+  const size_t buffer_pool_bytes = 1 << 20;
+  DiskManager disk_manager("test.db");
+  Transaction transaction(0);
+  page_id_t first_page_id;
+  std::vector<RID> rids;
+  LoadBenchmarkTable(&disk_manager, num_tuples, &transaction, &first_page_id, &rids);
+  ASSERT_EQ(num_tuples, rids.size());
+
+  BufferPoolManager bpm(buffer_pool_bytes / PAGE_SIZE, &disk_manager);
+  TableHeap table(&bpm, nullptr, nullptr, first_page_id);
+  auto start = std::chrono::steady_clock::now();
+  int count = 0;
+  for (auto itr = table.Begin(&transaction); itr != table.End(); ++itr) {
+    count++;
+  }
+  std::chrono::duration<double> scan_elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(num_tuples, count);
+  size_t scan_misses = bpm.GetNumMisses();
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<size_t> dist(0, rids.size() - 1);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_lookups; ++i) {
+    Tuple tuple;
+    ASSERT_TRUE(table.GetTuple(rids[dist(rng)], &tuple, &transaction));
+  }
+  std::chrono::duration<double> lookup_elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "page size " << PAGE_SIZE << ", " << buffer_pool_bytes / PAGE_SIZE << " frames: scan "
+            << num_tuples / scan_elapsed.count() << " tuples/s (" << scan_misses << " misses), point lookup "
+            << num_lookups / lookup_elapsed.count() << " lookups/s (" << bpm.GetNumMisses() - scan_misses
+            << " misses)" << std::endl;
+  disk_manager.ShutDown();
+  remove("test.db");
+}
+
+// Scans a table and looks up random tuples through a small buffer pool, which copies every page it reads, and through
+// the views of a mapped database file. The file is in the page cache for both. Run with
+// --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_MmapScanBenchmark) {
+  const int num_tuples = 20000;
+  const int num_lookups = 100000;
+  const size_t buffer_pool_size = 16;
+  Transaction transaction(0);
+  page_id_t first_page_id;
+  std::vector<RID> rids;
+  {
+    DiskManager disk_manager("test.db");
+    LoadBenchmarkTable(&disk_manager, num_tuples, &transaction, &first_page_id, &rids);
+    disk_manager.ShutDown();
+  }
+  ASSERT_EQ(num_tuples, rids.size());
+
+  for (bool mapped : {false, true}) {
+    std::unique_ptr<DiskManager> disk_manager;
+    if (mapped) {
+      disk_manager = std::make_unique<MmapDiskManager>("test.db");
+    } else {
+      disk_manager = std::make_unique<DiskManager>("test.db");
+    }
+    BufferPoolManager bpm(buffer_pool_size, disk_manager.get());
+    TableHeap table(&bpm, nullptr, nullptr, first_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto itr = table.Begin(&transaction); itr != table.End(); ++itr) {
+      count++;
+    }
+    std::chrono::duration<double> scan_elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(num_tuples, count);
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<size_t> dist(0, rids.size() - 1);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_lookups; ++i) {
+      Tuple tuple;
+      ASSERT_TRUE(table.GetTuple(rids[dist(rng)], &tuple, &transaction));
+    }
+    std::chrono::duration<double> lookup_elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << (mapped ? "mapped: " : "copied: ") << "scan " << num_tuples / scan_elapsed.count()
+              << " tuples/s, point lookup " << num_lookups / lookup_elapsed.count() << " lookups/s, "
+              << bpm.GetNumMisses() << " misses" << std::endl;
+    disk_manager->ShutDown();
+  }
+  remove("test.db");
+}
+
 }  // namespace bustub